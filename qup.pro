@@ -1,10 +1,28 @@
+lessThan(QT_MAJOR_VERSION, 5) | \
+if(equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 15)) {
+error("Qup requires Qt 5.15 or newer.")
+}
+
 macx {
 dmg.commands = make install && hdiutil create Qup.d.dmg -srcfolder Qup.d
 }
 
 unix {
-doxygen.commands = doxygen qup.doxygen
-purge.commands   = find . -name \'*~\' -exec rm {} \;
+benchmark.commands = ./Qup --benchmark --output benchmark.json
+doxygen.commands   = doxygen qup.doxygen
+loopback.commands  = ./Qup --benchmark --scenario loopback --files 200 \
+                     --output loopback.json && \
+                     ./Qup --benchmark --scenario loopback --files 200 \
+                     --pipelined --output loopback-pipelined.json
+micro.commands     = if test -r benchmarks/micro-baseline.json; then \
+                     ./Qup --benchmark --micro \
+                     --baseline benchmarks/micro-baseline.json \
+                     --output micro.json; else \
+                     ./Qup --benchmark --micro --output micro.json; fi
+micro_baseline.commands = mkdir -p benchmarks && \
+                          ./Qup --benchmark --micro \
+                          --output benchmarks/micro-baseline.json
+purge.commands     = find . -name \'*~\' -exec rm {} \;
 }
 
 CONFIG	    += qt release warn_on
@@ -110,13 +128,29 @@ QMAKE_MACOSX_DEPLOYMENT_TARGET = 13.0
 }
 
 unix {
-QMAKE_EXTRA_TARGETS += doxygen purge
+QMAKE_EXTRA_TARGETS += benchmark doxygen loopback micro micro_baseline purge
 }
 
 FORMS       += ui/qup.ui ui/qup_page.ui
 HEADERS     += source/qup.h \
+               source/qup_activity_model.h \
+               source/qup_batch.h \
+               source/qup_benchmark.h \
+               source/qup_benchmark_server.h \
+               source/qup_budget.h \
+               source/qup_favorites.h \
+               source/qup_files.h \
+               source/qup_files_model.h \
+               source/qup_headless.h \
+               source/qup_installer.h \
+               source/qup_journal.h \
+               source/qup_metrics.h \
                source/qup_page.h \
-               source/qup_swifty.h
+               source/qup_scheduler.h \
+               source/qup_staging.h \
+               source/qup_swifty.h \
+               source/qup_trace.h \
+               source/qup_updater.h
 INCLUDEPATH += source
 MOC_DIR     = temporary/moc
 OBJECTS_DIR = temporary/obj
@@ -124,8 +158,24 @@ PROJECTNAME = Qup
 RCC_DIR     = temporary/rcc
 RESOURCES   = documentation/documentation.qrc images/images.qrc
 SOURCES     += source/qup.cc \
+               source/qup_activity_model.cc \
+               source/qup_batch.cc \
+               source/qup_benchmark.cc \
+               source/qup_benchmark_server.cc \
+               source/qup_budget.cc \
+               source/qup_favorites.cc \
+               source/qup_files.cc \
+               source/qup_files_model.cc \
+               source/qup_headless.cc \
+               source/qup_installer.cc \
+               source/qup_journal.cc \
                source/qup_main.cc \
-               source/qup_page.cc
+               source/qup_metrics.cc \
+               source/qup_page.cc \
+               source/qup_scheduler.cc \
+               source/qup_staging.cc \
+               source/qup_trace.cc \
+               source/qup_updater.cc
 TARGET      = Qup
 TEMPLATE    = app
 UI_DIR      = temporary/ui
@@ -28,21 +28,42 @@
 #include <QActionGroup>
 #include <QCloseEvent>
 #include <QColorDialog>
+#include <QDateTime>
+#include <QDebug>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QHeaderView>
 #include <QNetworkProxy>
 #include <QPainter>
 #include <QRegularExpression>
 #include <QSettings>
+#include <QTableWidget>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVBoxLayout>
 
 #include "qup.h"
+#include "qup_activity_model.h"
+#include "qup_batch.h"
+#include "qup_favorites.h"
+#include "qup_journal.h"
 #include "qup_page.h"
+#include "qup_scheduler.h"
+#include "qup_staging.h"
 #include "qup_swifty.h"
+#include "qup_trace.h"
+#include "qup_updater.h"
 
 QColor qup::INVALID_PROCESS_COLOR = QColor(255, 114, 118);
 QColor qup::VALID_PROCESS_COLOR = QColor(144, 238, 144);
 QString qup::VERSION = "2025.03.08";
 QString qup::VERSION_LTS = "2025.03.08";
 static const char * const COMPILED_ON = __DATE__ " @ " __TIME__;
+const int static s_batch_connections = 16;
+const int static s_version_check_ttl = 24 * 60 * 60; // Seconds.
 
 qup::qup(void):QMainWindow()
 {
@@ -56,13 +77,20 @@ qup::qup(void):QMainWindow()
   m_about.setWindowIcon(windowIcon());
   m_about.setWindowModality(Qt::NonModal);
   m_about.setWindowTitle(tr("Qup: About"));
+  m_batch = nullptr;
+  m_favorites = new qup_favorites(this);
+  m_journal = new qup_journal(this);
+  m_painted = false;
+  m_release_notes = false;
+  m_scheduler = new qup_scheduler(m_favorites, this);
   m_swifty = new swifty
     (VERSION,
      "QString qup::VERSION_LTS = ",
      QUrl::fromUserInput("https://raw.githubusercontent.com/"
 			 "textbrowser/qup/master/source/qup.cc"),
      this);
-  m_swifty->download();
+  m_swifty->set_cache
+    (home_path() + QDir::separator() + "swifty.ini", s_version_check_ttl);
   assign_image(m_ui.process_invalid_color, INVALID_PROCESS_COLOR);
   assign_image(m_ui.process_valid_color, VALID_PROCESS_COLOR);
   connect(m_ui.action_about,
@@ -81,10 +109,18 @@ qup::qup(void):QMainWindow()
 	  &QAction::triggered,
 	  this,
 	  &qup::slot_quit);
+  connect(m_ui.action_update_all_favorites,
+	  &QAction::triggered,
+	  this,
+	  &qup::slot_update_all_favorites);
   connect(m_ui.pages,
 	  SIGNAL(tabCloseRequested(int)),
 	  this,
 	  SLOT(slot_tab_close_requested(int)));
+  connect(m_ui.tab,
+	  SIGNAL(currentChanged(int)),
+	  this,
+	  SLOT(slot_tab_changed(int)));
   connect(m_ui.process_invalid_color,
 	  &QPushButton::clicked,
 	  this,
@@ -105,6 +141,10 @@ qup::qup(void):QMainWindow()
 	  SIGNAL(currentIndexChanged(int)),
 	  this,
 	  SLOT(slot_save_proxy_type(int)));
+  connect(m_scheduler,
+	  &qup_scheduler::due,
+	  this,
+	  &qup::slot_scheduled);
   m_ui.action_close_page->setIcon(QIcon::fromTheme("window-close"));
   m_ui.action_new_page->setIcon(QIcon::fromTheme("document-new"));
   m_ui.menu_tabs->setStyleSheet("QMenu {menu-scrollable: 1;}");
@@ -112,15 +152,22 @@ qup::qup(void):QMainWindow()
     (INVALID_PROCESS_COLOR.name(QColor::HexArgb));
   m_ui.temporary_directory->setText(QDir::tempPath());
   m_ui.process_valid_color->setText(VALID_PROCESS_COLOR.name(QColor::HexArgb));
-  release_notes();
   restore_settings();
   set_proxy();
   slot_new_page();
   slot_proxy_changed(m_ui.proxy->text());
+  slot_tab_changed(m_ui.tab->currentIndex());
+  trace_startup("Main window constructed");
 }
 
 qup::~qup()
 {
+  /*
+  ** The updaters record activity in the journal.
+  */
+
+  delete m_batch;
+  qDeleteAll(m_updaters);
 }
 
 QString qup::home_path(void)
@@ -147,6 +194,34 @@ QString qup::home_path(void)
     }
 }
 
+bool qup::active(const QString &name) const
+{
+  for(int i = 0; i < m_ui.pages->count(); i++)
+    {
+      auto page = qobject_cast<qup_page *> (m_ui.pages->widget(i));
+
+      if(page && page->active() && page->product() == name)
+	return true;
+    }
+
+  auto updater = m_updaters.value(name);
+
+  return updater && updater->active();
+}
+
+bool qup::event(QEvent *event)
+{
+  auto const result = QMainWindow::event(event);
+
+  if(event && event->type() == QEvent::Paint && !m_painted)
+    {
+      m_painted = true;
+      QTimer::singleShot(0, this, &qup::slot_first_paint);
+    }
+
+  return result;
+}
+
 void qup::assign_image(QPushButton *button, const QColor &color)
 {
   if(!button)
@@ -253,6 +328,7 @@ void qup::release_notes(void)
     m_ui.release_notes->setHtml(file.readAll());
 
   file.close();
+  trace_startup("Release notes prepared");
 }
 
 void qup::restore_settings(void)
@@ -275,13 +351,16 @@ void qup::restore_settings(void)
 
 void qup::set_proxy(void)
 {
+  /*
+  ** The proxy of the INI file: 0 is HTTP, 1 is SOCKS, and 2 is the
+  ** system's configuration. Also issued by the headless modes.
+  */
+
   QNetworkProxyFactory::setUseSystemConfiguration(false);
 
-  auto const proxy_type
-    (m_ui.proxy_type->
-     itemText(QSettings().value("proxy-type-index", 2).toInt()));
+  auto const proxy_type = QSettings().value("proxy-type-index", 2).toInt();
 
-  if(proxy_type == tr("HTTP") || proxy_type == tr("SOCKS"))
+  if(proxy_type == 0 || proxy_type == 1)
     {
       QNetworkProxy proxy;
       auto const list
@@ -290,7 +369,7 @@ void qup::set_proxy(void)
       proxy.setHostName(list.value(0).trimmed());
       proxy.setPort(list.value(1).trimmed().toUShort());
 
-      if(proxy_type == tr("HTTP"))
+      if(proxy_type == 0)
 	proxy.setType(QNetworkProxy::HttpProxy);
       else
 	proxy.setType(QNetworkProxy::Socks5Proxy);
@@ -335,19 +414,82 @@ void qup::slot_about(void)
   m_about.raise();
 }
 
+void qup::slot_batch_finished(const bool ok)
+{
+  if(!m_batch)
+    return;
+
+  auto buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+  auto dialog = new QDialog(this);
+  auto layout = new QVBoxLayout(dialog);
+  auto table = new QTableWidget(dialog);
+  auto const rows(m_batch->rows());
+
+  table->setColumnCount(m_batch->headers().size());
+  table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  table->setHorizontalHeaderLabels(m_batch->headers());
+  table->setRowCount(rows.size());
+  table->setSelectionBehavior(QAbstractItemView::SelectRows);
+  table->verticalHeader()->setVisible(false);
+
+  for(int i = 0; i < rows.size(); i++)
+    for(int j = 0; j < rows.at(i).size(); j++)
+      {
+	auto item = new QTableWidgetItem(rows.at(i).at(j));
+
+	if(j == 1)
+	  item->setBackground
+	    (rows.at(i).at(j) == tr("Updated") ?
+	     VALID_PROCESS_COLOR : INVALID_PROCESS_COLOR);
+	else if(j > 1)
+	  item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+	table->setItem(i, j, item);
+      }
+
+  table->horizontalHeader()->setStretchLastSection(true);
+  table->resizeColumnsToContents();
+  connect(buttons,
+	  &QDialogButtonBox::rejected,
+	  dialog,
+	  &QDialog::close);
+  layout->addWidget(table);
+  layout->addWidget(buttons);
+  dialog->resize(600, 400);
+  dialog->setAttribute(Qt::WA_DeleteOnClose);
+  dialog->setWindowIcon(windowIcon());
+  dialog->setWindowTitle(tr("Qup: Update All Favorites"));
+  dialog->show();
+  m_batch->deleteLater();
+  m_batch = nullptr;
+  m_ui.action_update_all_favorites->setEnabled(true);
+  m_ui.statusbar->showMessage
+    (ok ?
+     tr("Every favorite has been updated.") :
+     tr("Some favorites were not updated. Please review."),
+     5000);
+}
+
 void qup::slot_close_page(void)
 {
   close_page(m_ui.pages->widget(m_ui.pages->currentIndex()));
 }
 
+void qup::slot_first_paint(void)
+{
+  /*
+  ** Work which is not required by the first frame.
+  */
+
+  trace_startup("First paint");
+  m_swifty->download();
+  QThreadPool::globalInstance()->start(&qup_staging::collect_garbage);
+}
+
 void qup::slot_new_page(void)
 {
-  auto page = new qup_page(this);
+  auto page = new qup_page(m_favorites, m_journal, this);
 
-  connect(page,
-	  &qup_page::populate_favorites,
-	  this,
-	  &qup::populate_favorites);
   connect(page,
 	  SIGNAL(product_name_changed(const QString &)),
 	  this,
@@ -356,10 +498,6 @@ void qup::slot_new_page(void)
 	  &QAction::triggered,
 	  this,
 	  &qup::slot_select_page);
-  connect(this,
-	  &qup::populate_favorites,
-	  page,
-	  &qup_page::slot_populate_favorites);
   connect(this,
 	  &qup::settings_applied,
 	  page,
@@ -412,6 +550,53 @@ void qup::slot_save_proxy_type(int index)
   set_proxy();
 }
 
+void qup::slot_scheduled(const QString &name)
+{
+  /*
+  ** A page which presents the favorite performs the update. Otherwise,
+  ** the favorite is updated in the background and its activity is
+  ** recorded in its journal. Favorites are not scheduled while all of
+  ** them are being updated.
+  */
+
+  if(m_batch)
+    return;
+
+  for(int i = 0; i < m_ui.pages->count(); i++)
+    {
+      auto page = qobject_cast<qup_page *> (m_ui.pages->widget(i));
+
+      if(page && page->product() == name)
+	{
+	  page->active() ? (void) 0 : page->download();
+	  return;
+	}
+    }
+
+  auto updater = m_updaters.value(name);
+
+  if(!updater)
+    {
+      updater = new qup_updater(this);
+      connect(updater,
+	      &qup_updater::append,
+	      this,
+	      [this, name](const QString &text)
+	      {
+		m_journal->write
+		  (name,
+		   QDateTime::currentMSecsSinceEpoch(),
+		   qup_activity_model::level(text),
+		   qup_activity_model::plain_text(text));
+	      },
+	      Qt::DirectConnection);
+      m_updaters[name] = updater;
+    }
+
+  if(!updater->active())
+    updater->download(qup_updater::favorite(m_favorites->values(name)));
+}
+
 void qup::slot_select_color(void)
 {
   if(!(m_ui.process_invalid_color == sender() ||
@@ -466,11 +651,68 @@ void qup::slot_select_page(void)
   m_ui.tab->setCurrentIndex(0);
 }
 
+void qup::slot_tab_changed(int index)
+{
+  if(m_release_notes || m_ui.tab->widget(index) != m_ui.page_release_notes)
+    return;
+
+  m_release_notes = true;
+  release_notes();
+}
+
 void qup::slot_tab_close_requested(int index)
 {
   close_page(m_ui.pages->widget(index));
 }
 
+void qup::slot_update_all_favorites(void)
+{
+  /*
+  ** Every favorite which is not being updated is downloaded and
+  ** installed under one budget. Activity is recorded in the favorites'
+  ** journals. A summary is presented once every update has completed.
+  */
+
+  if(m_batch)
+    return;
+
+  QStringList names;
+
+  foreach(auto const &name, m_favorites->names())
+    if(!active(name))
+      names << name;
+
+  if(names.isEmpty())
+    {
+      m_ui.statusbar->showMessage
+	(tr("The Qup INI file does not define idle favorites."), 5000);
+      return;
+    }
+
+  m_batch = new qup_batch
+    (s_batch_connections, qMax(1, QThread::idealThreadCount()), 0, this);
+  connect(m_batch,
+	  &qup_batch::append,
+	  this,
+	  [this](const QString &name, const QString &text)
+	  {
+	    m_journal->write
+	      (name,
+	       QDateTime::currentMSecsSinceEpoch(),
+	       qup_activity_model::level(text),
+	       qup_activity_model::plain_text(text));
+	  },
+	  Qt::DirectConnection);
+  connect(m_batch,
+	  &qup_batch::finished,
+	  this,
+	  &qup::slot_batch_finished);
+  m_ui.action_update_all_favorites->setEnabled(false);
+  m_ui.statusbar->showMessage
+    (tr("Updating %1 favorite(s)...").arg(names.size()));
+  m_batch->start(names);
+}
+
 void qup::prepare_tabs_menu(void)
 {
   m_ui.menu_tabs->clear();
@@ -511,3 +753,23 @@ void qup::prepare_tabs_menu(void)
 	}
     }
 }
+
+void qup::trace_startup(const QString &mark)
+{
+  /*
+  ** The time since the first mark is written if QUP_STARTUP_TRACE
+  ** is defined. The marks are also timeline markers if QUP_TRACE is
+  ** defined.
+  */
+
+  static QElapsedTimer timer;
+
+  if(!timer.isValid())
+    timer.start();
+
+  qup_trace::instant("startup", "Start-up", mark);
+
+  if(qEnvironmentVariableIsSet("QUP_STARTUP_TRACE"))
+    qDebug().noquote() << QString("Start-up: %1 ms, %2.").
+      arg(timer.elapsed(), 6).arg(mark);
+}
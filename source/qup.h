@@ -28,10 +28,16 @@
 #ifndef _qup_h_
 #define _qup_h_
 
+#include <QHash>
 #include <QMessageBox>
 
 #include "ui_qup.h"
 
+class qup_batch;
+class qup_favorites;
+class qup_journal;
+class qup_scheduler;
+class qup_updater;
 class swifty;
 
 class qup: public QMainWindow
@@ -47,33 +53,47 @@ class qup: public QMainWindow
   static QString VERSION_LTS;
   static QString home_path(void);
   static void assign_image(QPushButton *button, const QColor &color);
+  static void set_proxy(void);
+  static void trace_startup(const QString &mark);
 
  private:
+  QHash<QString, qup_updater *> m_updaters;
   QMessageBox m_about;
   Ui_qup m_ui;
+  bool m_painted;
+  bool m_release_notes;
+  qup_batch *m_batch;
+  qup_favorites *m_favorites;
+  qup_journal *m_journal;
+  qup_scheduler *m_scheduler;
   swifty *m_swifty;
+  bool active(const QString &name) const;
+  bool event(QEvent *event);
   void closeEvent(QCloseEvent *event);
   void close_page(QWidget *widget);
   void prepare_tabs_menu(void);
   void release_notes(void);
   void restore_settings(void);
-  void set_proxy(void);
 
  private slots:
   void slot_about(void);
+  void slot_batch_finished(const bool ok);
   void slot_close_page(void);
+  void slot_first_paint(void);
   void slot_new_page(void);
   void slot_product_name_changed(const QString &t);
   void slot_proxy_changed(const QString &text);
   void slot_quit(void);
   void slot_save_proxy(void);
   void slot_save_proxy_type(int index);
+  void slot_scheduled(const QString &name);
   void slot_select_color(void);
   void slot_select_page(void);
+  void slot_tab_changed(int index);
   void slot_tab_close_requested(int index);
+  void slot_update_all_favorites(void);
 
  signals:
-  void populate_favorites(void);
   void settings_applied(void);
 };
 
@@ -0,0 +1,270 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QColor>
+#include <QDateTime>
+#include <QFont>
+
+#include "qup_activity_model.h"
+
+const int static s_flush_interval = 16; // Milliseconds, about one frame.
+
+qup_activity_model::qup_activity_model
+(const int capacity, QObject *parent):QAbstractListModel(parent)
+{
+  m_capacity = qMax(1, capacity);
+  m_count = 0;
+  m_first = 0;
+  m_journal = nullptr;
+  m_timer.setInterval(s_flush_interval);
+  m_timer.setSingleShot(true);
+  connect(&m_timer,
+	  &QTimer::timeout,
+	  this,
+	  &qup_activity_model::slot_flush);
+}
+
+qup_activity_model::~qup_activity_model()
+{
+  m_timer.stop();
+}
+
+QString qup_activity_model::plain_text(const QString &text)
+{
+  return entry(text).m_text;
+}
+
+QVariant qup_activity_model::data(const QModelIndex &index, int role) const
+{
+  if(!index.isValid() || index.row() < 0 || index.row() >= m_count)
+    return QVariant();
+
+  auto const &entry(m_entries.at((m_first + index.row()) % m_capacity));
+
+  switch(role)
+    {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+      {
+	return QString("[%1]: %2").
+	  arg(QDateTime::fromMSecsSinceEpoch(entry.m_time).
+	      toString(Qt::ISODate)).
+	  arg(entry.m_text);
+      }
+    case Qt::FontRole:
+      {
+	if(entry.m_style & Bold)
+	  {
+	    QFont font;
+
+	    font.setBold(true);
+	    return font;
+	  }
+
+	break;
+      }
+    case Qt::ForegroundRole:
+      {
+	if(entry.m_style & Failure)
+	  return QColor("darkred");
+	else if(entry.m_style & Success)
+	  return QColor("darkgreen");
+
+	break;
+      }
+    default:
+      {
+	break;
+      }
+    }
+
+  return QVariant();
+}
+
+int qup_activity_model::capacity(void) const
+{
+  return m_capacity;
+}
+
+int qup_activity_model::rowCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : m_count;
+}
+
+qup_activity_model::Entry qup_activity_model::entry(const QString &text)
+{
+  /*
+  ** Activity is composed with a few HTML tags. Retain the styles and
+  ** discard the markup.
+  */
+
+  Entry entry;
+  auto tag = false;
+
+  if(text.contains("<b>"))
+    entry.m_style |= Bold;
+
+  if(text.contains("darkred"))
+    entry.m_style |= Failure;
+  else if(text.contains("darkgreen"))
+    entry.m_style |= Success;
+
+  entry.m_text.reserve(text.size());
+
+  for(int i = 0; i < text.size(); i++)
+    if(text.at(i) == '<')
+      tag = true;
+    else if(text.at(i) == '>' && tag)
+      tag = false;
+    else if(!tag)
+      entry.m_text.append(text.at(i));
+
+  entry.m_text.replace("&amp;", "&");
+  entry.m_text.replace("&gt;", ">");
+  entry.m_text.replace("&lt;", "<");
+  entry.m_text = entry.m_text.trimmed();
+  entry.m_time = QDateTime::currentMSecsSinceEpoch();
+  return entry;
+}
+
+qup_journal::Levels qup_activity_model::level(const QString &text)
+{
+  return level(entry(text).m_style);
+}
+
+qup_journal::Levels qup_activity_model::level(const quint8 style)
+{
+  if(style & Failure)
+    return qup_journal::Levels::Failure;
+  else if(style & Success)
+    return qup_journal::Levels::Success;
+  else
+    return qup_journal::Levels::Information;
+}
+
+void qup_activity_model::append(const QString &text)
+{
+  /*
+  ** May be issued by any thread. Entries are prepared here and
+  ** delivered to the view at most once per frame.
+  */
+
+  if(text.trimmed().isEmpty())
+    return;
+
+  auto const e(entry(text));
+  QMutexLocker locker(&m_pending_mutex);
+
+  if(m_journal)
+    m_journal->write(m_journal_name, e.m_time, level(e.m_style), e.m_text);
+
+  m_pending << e;
+
+  if(m_pending.size() == 1)
+    QMetaObject::invokeMethod(this, "slot_schedule", Qt::QueuedConnection);
+}
+
+void qup_activity_model::clear(void)
+{
+  {
+    QMutexLocker locker(&m_pending_mutex);
+
+    m_pending.clear();
+  }
+
+  beginResetModel();
+  m_count = 0;
+  m_entries.clear();
+  m_first = 0;
+  endResetModel();
+}
+
+void qup_activity_model::set_journal(qup_journal *journal)
+{
+  QMutexLocker locker(&m_pending_mutex);
+
+  m_journal = journal;
+}
+
+void qup_activity_model::set_journal_name(const QString &name)
+{
+  QMutexLocker locker(&m_pending_mutex);
+
+  m_journal_name = name;
+}
+
+void qup_activity_model::slot_flush(void)
+{
+  QVector<Entry> pending;
+
+  {
+    QMutexLocker locker(&m_pending_mutex);
+
+    pending.swap(m_pending);
+  }
+
+  if(pending.isEmpty())
+    return;
+  else if(pending.size() > m_capacity)
+    pending = pending.mid(pending.size() - m_capacity);
+
+  /*
+  ** The oldest entries are discarded as newer entries arrive.
+  */
+
+  auto const overflow = qMax(0, m_count + pending.size() - m_capacity);
+
+  if(overflow > 0)
+    {
+      beginRemoveRows(QModelIndex(), 0, overflow - 1);
+      m_count -= overflow;
+      m_first = (m_first + overflow) % m_capacity;
+      endRemoveRows();
+    }
+
+  beginInsertRows(QModelIndex(), m_count, m_count + pending.size() - 1);
+
+  for(int i = 0; i < pending.size(); i++)
+    {
+      auto const w = (m_first + m_count) % m_capacity;
+
+      if(w == m_entries.size())
+	m_entries << pending.at(i);
+      else
+	m_entries[w] = pending.at(i);
+
+      m_count += 1;
+    }
+
+  endInsertRows();
+}
+
+void qup_activity_model::slot_schedule(void)
+{
+  if(!m_timer.isActive())
+    m_timer.start();
+}
@@ -0,0 +1,96 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_activity_model_h_
+#define _qup_activity_model_h_
+
+#include <QAbstractListModel>
+#include <QMutex>
+#include <QTimer>
+#include <QVector>
+
+#include "qup_journal.h"
+
+class qup_activity_model: public QAbstractListModel
+{
+  Q_OBJECT
+
+ public:
+  qup_activity_model(const int capacity, QObject *parent);
+  ~qup_activity_model();
+  QVariant data(const QModelIndex &index, int role) const;
+  int capacity(void) const;
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  static QString plain_text(const QString &text);
+  static qup_journal::Levels level(const QString &text);
+  void append(const QString &text);
+  void set_journal(qup_journal *journal);
+  void set_journal_name(const QString &name);
+
+ public slots:
+  void clear(void);
+
+ private:
+  enum Styles
+  {
+    Bold = 1,
+    Failure = 2,
+    Success = 4
+  };
+
+  class Entry
+  {
+  public:
+    Entry(void)
+    {
+      m_style = 0;
+      m_time = 0;
+    }
+
+    QString m_text;
+    qint64 m_time;
+    quint8 m_style;
+  };
+
+  QMutex m_pending_mutex;
+  QString m_journal_name;
+  QTimer m_timer;
+  QVector<Entry> m_entries; // Ring buffer.
+  QVector<Entry> m_pending;
+  int m_capacity;
+  int m_count;
+  int m_first;
+  qup_journal *m_journal;
+  static Entry entry(const QString &text);
+  static qup_journal::Levels level(const quint8 style);
+
+ private slots:
+  void slot_flush(void);
+  void slot_schedule(void);
+};
+
+#endif
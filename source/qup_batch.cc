@@ -0,0 +1,250 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDir>
+#include <QRegularExpression>
+
+#include "qup_batch.h"
+#include "qup_budget.h"
+#include "qup_updater.h"
+
+qup_batch::qup_batch(const int connections,
+		     const int disk_workers,
+		     const qint64 bandwidth,
+		     QObject *parent):QObject(parent)
+{
+  m_budget = new qup_budget(connections, disk_workers, bandwidth, this);
+  m_remaining = 0;
+}
+
+qup_batch::~qup_batch()
+{
+  /*
+  ** The updaters release their connections while being destroyed.
+  */
+
+  foreach(auto updater, m_updaters)
+    if(updater)
+      updater->interrupt();
+
+  qDeleteAll(m_updaters);
+}
+
+QStringList qup_batch::headers(void) const
+{
+  return QStringList() << tr("Favorite")
+		       << tr("Result")
+		       << tr("Files")
+		       << tr("Bytes")
+		       << tr("Seconds");
+}
+
+QStringList qup_batch::summary(void) const
+{
+  QVector<int> widths;
+  auto const header(headers());
+  auto const table(rows());
+
+  for(int i = 0; i < header.size(); i++)
+    {
+      auto width = header.at(i).size();
+
+      foreach(auto const &row, table)
+	width = qMax(width, row.at(i).size());
+
+      widths << width;
+    }
+
+  QStringList lines;
+  auto const line = [&widths](const QStringList &row)
+		    {
+		      /*
+		      ** Text is aligned left, numbers right.
+		      */
+
+		      QStringList columns;
+
+		      for(int i = 0; i < row.size(); i++)
+			columns << (i < 2 ?
+				    row.at(i).leftJustified(widths.at(i)) :
+				    row.at(i).rightJustified(widths.at(i)));
+
+		      return columns.join("  ").trimmed();
+		    };
+
+  lines << line(header);
+
+  foreach(auto const &row, table)
+    lines << line(row);
+
+  return lines;
+}
+
+QVector<QStringList> qup_batch::rows(void) const
+{
+  QVector<QStringList> table;
+
+  foreach(auto const &result, m_results)
+    {
+      QStringList row;
+
+      row << result.m_name
+	  << (result.m_ok ? tr("Updated") : tr("Failed"))
+	  << QString::number(result.m_files)
+	  << QString::number(result.m_bytes)
+	  << QString::number(static_cast<double> (result.m_elapsed) / 1000.0,
+			     'f',
+			     1);
+      table << row;
+    }
+
+  return table;
+}
+
+bool qup_batch::ok(void) const
+{
+  foreach(auto const &result, m_results)
+    if(!result.m_ok)
+      return false;
+
+  return true;
+}
+
+void qup_batch::record(const int index, const bool ok)
+{
+  if(index < 0 || index >= m_results.size() || m_results.at(index).m_done)
+    return;
+
+  auto &result(m_results[index]);
+
+  result.m_done = true;
+  result.m_elapsed = result.m_timer.elapsed();
+  result.m_ok = ok;
+
+  if(index < m_updaters.size() && m_updaters.at(index))
+    {
+      result.m_bytes = m_updaters.at(index)->downloaded_bytes();
+      result.m_files = m_updaters.at(index)->downloaded_files();
+
+      auto const file_name
+	(m_metrics_directory +
+	 QDir::separator() +
+	 QString("qup_%1.prom").
+	 arg(QString(result.m_name).
+	     replace(QRegularExpression("[^0-9A-Za-z._-]"), "_")));
+
+      if(!m_metrics_directory.isEmpty() &&
+	 !m_updaters.at(index)->metrics()->write(file_name, result.m_name))
+	emit append
+	  (result.m_name,
+	   tr("<font color='darkred'>The metrics could not be written to "
+	      "%1.</font>").arg(file_name));
+    }
+
+  if(--m_remaining == 0)
+    emit finished(this->ok());
+}
+
+void qup_batch::set_metrics_directory(const QString &directory)
+{
+  /*
+  ** Each favorite's metrics are written in the Prometheus text format
+  ** once its update has completed.
+  */
+
+  m_metrics_directory = directory;
+}
+
+void qup_batch::start(const QStringList &names)
+{
+  /*
+  ** Favorites are installed after they are downloaded.
+  */
+
+  m_remaining = names.size();
+  m_results.resize(names.size());
+  m_updaters.fill(nullptr, names.size());
+
+  for(int i = 0; i < names.size(); i++)
+    {
+      auto favorite(qup_updater::favorite(names.at(i)));
+
+      favorite.m_install_automatically = true;
+      m_results[i].m_name = names.at(i);
+      m_results[i].m_timer.start();
+
+      if(favorite.m_destination.isEmpty() ||
+	 favorite.m_url.isEmpty() ||
+	 favorite.m_url.isValid() == false)
+	{
+	  emit append
+	    (names.at(i),
+	     tr("<font color='darkred'>%1 does not have a product directory "
+		"and a valid product URL.</font>").arg(names.at(i)));
+	  QMetaObject::invokeMethod
+	    (this,
+	     [this, i](void)
+	     {
+	       record(i, false);
+	     },
+	     Qt::QueuedConnection);
+	  continue;
+	}
+
+      auto const name(names.at(i));
+      auto updater = new qup_updater(this);
+
+      connect(updater,
+	      &qup_updater::append,
+	      this,
+	      [this, name](const QString &text)
+	      {
+		emit append(name, text);
+	      },
+	      Qt::DirectConnection);
+      connect(updater,
+	      &qup_updater::finished,
+	      this,
+	      [this, i](const bool ok)
+	      {
+		record(i, ok);
+	      },
+	      Qt::QueuedConnection);
+      m_updaters[i] = updater;
+      updater->set_budget(m_budget);
+      updater->download(favorite);
+    }
+
+  if(names.isEmpty())
+    QMetaObject::invokeMethod
+      (this,
+       [this](void)
+       {
+	 emit finished(true);
+       },
+       Qt::QueuedConnection);
+}
@@ -0,0 +1,94 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_batch_h_
+#define _qup_batch_h_
+
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+
+class qup_budget;
+class qup_updater;
+
+/*
+** Updates several favorites concurrently. Instruction files are
+** retrieved at once; downloads and installs share one budget.
+*/
+
+class qup_batch: public QObject
+{
+  Q_OBJECT
+
+ public:
+  qup_batch(const int connections,
+	    const int disk_workers,
+	    const qint64 bandwidth,
+	    QObject *parent);
+  ~qup_batch();
+  QStringList headers(void) const;
+  QStringList summary(void) const;
+  QVector<QStringList> rows(void) const;
+  bool ok(void) const;
+  void set_metrics_directory(const QString &directory);
+  void start(const QStringList &names);
+
+ private:
+  class Result
+  {
+  public:
+    Result(void)
+    {
+      m_bytes = 0;
+      m_done = false;
+      m_elapsed = 0;
+      m_files = 0;
+      m_ok = false;
+    }
+
+    QElapsedTimer m_timer;
+    QString m_name;
+    bool m_done;
+    bool m_ok;
+    int m_files;
+    qint64 m_bytes;
+    qint64 m_elapsed; // Milliseconds.
+  };
+
+  QString m_metrics_directory;
+  QVector<Result> m_results;
+  QVector<qup_updater *> m_updaters;
+  int m_remaining;
+  qup_budget *m_budget;
+  void record(const int index, const bool ok);
+
+ signals:
+  void append(const QString &name, const QString &text);
+  void finished(const bool ok);
+};
+
+#endif
@@ -0,0 +1,787 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "qup.h"
+#include "qup_benchmark.h"
+#include "qup_budget.h"
+#include "qup_files.h"
+#include "qup_updater.h"
+
+const int static s_block_size = 65536;
+const int static s_connections = 16;
+const int static s_depth = 3;
+const int static s_fan_out = 8; // Directories per level.
+const int static s_files = 1000;
+const int static s_iterations = 100000;
+const int static s_rounds = 5;
+const int static s_tolerance = 25; // Percent.
+const qint64 static s_maximum_size = 1048576;
+const qint64 static s_minimum_size = 1024;
+
+qup_benchmark::qup_benchmark(QObject *parent):QObject(parent)
+{
+  m_budget = nullptr;
+  m_bytes = 0;
+  m_connections = s_connections;
+  m_deadline = 0;
+  m_depth = s_depth;
+  m_disk_workers = qMax(1, QThread::idealThreadCount());
+  m_download_time = 0;
+  m_expect_success = true;
+  m_files = s_files;
+  m_install_pipelined = false;
+  m_install_time = 0;
+  m_iterations = s_iterations;
+  m_manifest_time = 0;
+  m_maximum_size = s_maximum_size;
+  m_micro = false;
+  m_minimum_size = s_minimum_size;
+  m_scenario = "loopback";
+  m_seed = 1;
+  m_server = nullptr;
+  m_tolerance = s_tolerance;
+  m_updater = nullptr;
+}
+
+qup_benchmark::~qup_benchmark()
+{
+  if(m_updater)
+    m_updater->interrupt();
+
+  delete m_updater;
+  delete m_server;
+}
+
+QString qup_benchmark::relative_path(const int index) const
+{
+  QString path("");
+  auto n = index;
+
+  for(int i = 0; i < m_depth; i++)
+    {
+      path.append(QString("d%1/").arg(n % s_fan_out));
+      n /= s_fan_out;
+    }
+
+  path.append(QString("file-%1.bin").arg(index));
+  return path;
+}
+
+bool qup_benchmark::generate(const QString &directory, const quint16 port)
+{
+  /*
+  ** The files are distributed over a tree of s_fan_out directories per
+  ** level. Sizes are log-uniform between the minimum and the maximum.
+  ** Every file begins with its index so that no two files are equal.
+  */
+
+  QByteArray block(s_block_size, 0);
+  QRandomGenerator generator(m_seed);
+  QString manifest("[General]\n");
+
+  for(int i = 0; i < block.size(); i++)
+    block[i] = static_cast<char> (generator.bounded(256));
+
+  m_bytes = 0;
+
+  for(int i = 0; i < m_files; i++)
+    {
+      auto const path(relative_path(i));
+      auto const size = qMax
+	(1LL,
+	 static_cast<qint64>
+	 (std::exp(std::log(static_cast<double> (m_minimum_size)) +
+		   generator.bounded(1.0) *
+		   (std::log(static_cast<double> (m_maximum_size)) -
+		    std::log(static_cast<double> (m_minimum_size))))));
+      QFile file(directory + QDir::separator() + path);
+
+      if(!QDir().mkpath(QFileInfo(file.fileName()).absolutePath()) ||
+	 !file.open(QIODevice::Truncate | QIODevice::WriteOnly))
+	return false;
+
+      auto const header(QByteArray::number(i).append('\n'));
+      qint64 written = file.write
+	(header.mid(0, static_cast<int> (qMin(size, 1LL * header.size()))));
+
+      while(written >= 0 && written < size)
+	{
+	  auto const w = file.write
+	    (block.constData(), qMin(size - written, block.size() * 1LL));
+
+	  if(w <= 0)
+	    return false;
+
+	  written += w;
+	}
+
+      m_bytes += size;
+      manifest.append(QString("file = %1\n").arg(path));
+    }
+
+  manifest.append
+    (QString("url = http://127.0.0.1:%1/product\n").arg(port));
+
+  QFile file(directory + QDir::separator() + "qup.txt");
+
+  return file.open(QIODevice::Text |
+		   QIODevice::Truncate |
+		   QIODevice::WriteOnly) &&
+    file.write(manifest.toUtf8()) == manifest.toUtf8().size();
+}
+
+bool qup_benchmark::parse(const QStringList &arguments)
+{
+  for(int i = 1; i < arguments.size(); i++)
+    {
+      auto const argument(arguments.at(i));
+      auto const value(i + 1 < arguments.size() ? arguments.at(i + 1) : "");
+      auto ok = true;
+
+      if(argument == "--bandwidth-cap" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_conditions.m_bandwidth = 1024LL * value.toLongLong(&ok);
+	  ok = ok && m_conditions.m_bandwidth >= 0;
+	}
+      else if(argument == "--baseline" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_baseline = value;
+	}
+      else if(argument == "--benchmark")
+	continue;
+      else if(argument == "--connections" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_connections = value.toInt(&ok);
+	  ok = ok && m_connections > 0;
+	}
+      else if(argument == "--deadline" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_deadline = value.toLongLong(&ok);
+	  ok = ok && m_deadline >= 0;
+	}
+      else if(argument == "--depth" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_depth = value.toInt(&ok);
+	  ok = ok && m_depth >= 0;
+	}
+      else if(argument == "--disk-workers" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_disk_workers = value.toInt(&ok);
+	  ok = ok && m_disk_workers > 0;
+	}
+      else if(argument == "--error-burst" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_conditions.m_error_burst = value.toInt(&ok);
+	  ok = ok && m_conditions.m_error_burst >= 0;
+	}
+      else if(argument == "--error-rate" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_conditions.m_error_rate = value.toInt(&ok);
+	  ok = ok &&
+	    m_conditions.m_error_rate >= 0 &&
+	    m_conditions.m_error_rate <= 100;
+	}
+      else if(argument == "--expect" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_expect_success = value == "success";
+	  ok = value == "failure" || value == "success";
+	}
+      else if(argument == "--files" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_files = value.toInt(&ok);
+	  ok = ok && m_files > 0;
+	}
+      else if(argument == "--first-byte" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_conditions.m_first_byte = value.toInt(&ok);
+	  ok = ok && m_conditions.m_first_byte >= 0;
+	}
+      else if(argument == "--iterations" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_iterations = value.toInt(&ok);
+	  ok = ok && m_iterations > 0;
+	}
+      else if(argument == "--latency" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_conditions.m_latency = value.toInt(&ok);
+	  ok = ok && m_conditions.m_latency >= 0;
+	}
+      else if(argument == "--maximum-size" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_maximum_size = value.toLongLong(&ok);
+	}
+      else if(argument == "--micro")
+	m_micro = true;
+      else if(argument == "--minimum-size" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_minimum_size = value.toLongLong(&ok);
+	}
+      else if(argument == "--output" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_output = value;
+	}
+      else if(argument == "--pipelined")
+	m_install_pipelined = true;
+      else if(argument == "--reset-rate" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_conditions.m_reset_rate = value.toInt(&ok);
+	  ok = ok &&
+	    m_conditions.m_reset_rate >= 0 &&
+	    m_conditions.m_reset_rate <= 100;
+	}
+      else if(argument == "--scenario" && !value.isEmpty())
+	{
+	  i += 1;
+	  ok = scenario(value);
+	}
+      else if(argument == "--seed" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_seed = value.toUInt(&ok);
+	  m_conditions.m_seed = m_seed;
+	}
+      else if(argument == "--tolerance" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_tolerance = value.toInt(&ok);
+	  ok = ok && m_tolerance >= 0;
+	}
+      else
+	ok = false;
+
+      if(!ok)
+	return false;
+    }
+
+  return m_minimum_size > 0 && m_minimum_size <= m_maximum_size;
+}
+
+bool qup_benchmark::requested(int argc, char *argv[])
+{
+  for(int i = 1; i < argc; i++)
+    if(qstrcmp(argv[i], "--benchmark") == 0)
+      return true;
+
+  return false;
+}
+
+bool qup_benchmark::scenario(const QString &name)
+{
+  /*
+  ** A scenario's conditions may be refined by subsequent options.
+  ** Resets and server errors are not retried by Qup, so their
+  ** updates are expected to fail.
+  */
+
+  auto const seed = m_conditions.m_seed;
+
+  m_conditions = qup_benchmark_server::Conditions();
+  m_conditions.m_seed = seed;
+  m_expect_success = true;
+  m_scenario = name;
+
+  if(name == "high-latency")
+    m_conditions.m_latency = 300;
+  else if(name == "loopback")
+    return true;
+  else if(name == "low-bandwidth")
+    m_conditions.m_bandwidth = 64LL * 1024LL;
+  else if(name == "resets")
+    {
+      m_conditions.m_reset_rate = 10;
+      m_expect_success = false;
+    }
+  else if(name == "satellite")
+    {
+      m_conditions.m_bandwidth = 128LL * 1024LL;
+      m_conditions.m_latency = 600;
+    }
+  else if(name == "server-errors")
+    {
+      m_conditions.m_error_burst = 5;
+      m_conditions.m_error_rate = 2;
+      m_expect_success = false;
+    }
+  else if(name == "slow-first-byte")
+    m_conditions.m_first_byte = 2000;
+  else
+    return false;
+
+  return true;
+}
+
+bool qup_benchmark::write(const QJsonObject &object) const
+{
+  auto const json(QJsonDocument(object).toJson(QJsonDocument::Indented));
+
+  if(m_output.isEmpty())
+    {
+      QTextStream stream(stdout);
+
+      stream << json;
+      stream.flush();
+      return true;
+    }
+
+  QFile file(m_output);
+
+  if(!file.open(QIODevice::Truncate | QIODevice::WriteOnly) ||
+     file.write(json) != json.size())
+    {
+      QTextStream(stderr) << tr("Cannot write %1.").arg(m_output) << "\n";
+      return false;
+    }
+
+  return true;
+}
+
+int qup_benchmark::exec(void)
+{
+  QTextStream stream(stderr);
+
+  if(!parse(QCoreApplication::arguments()))
+    {
+      stream << tr("Usage: qup --benchmark [--connections <count>] "
+		   "[--deadline <ms>] [--depth <count>] "
+		   "[--disk-workers <count>] [--expect success | failure] "
+		   "[--files <count>] [--maximum-size <bytes>] "
+		   "[--micro [--baseline <file>] [--iterations <count>] "
+		   "[--tolerance <percent>]] "
+		   "[--minimum-size <bytes>] [--output <file>] "
+		   "[--pipelined] [--scenario high-latency | loopback | "
+		   "low-bandwidth | resets | satellite | "
+		   "server-errors | slow-first-byte] [--seed <number>] "
+		   "[--bandwidth-cap <KiB/s>] [--error-burst <count>] "
+		   "[--error-rate <percent>] [--first-byte <ms>] "
+		   "[--latency <ms>] "
+		   "[--reset-rate <percent>]")
+	     << "\n";
+      return static_cast<int> (ExitCodes::Usage);
+    }
+
+  if(m_micro)
+    return micro();
+
+  if(!m_directory.isValid())
+    {
+      stream << tr("A temporary directory cannot be created.") << "\n";
+      return static_cast<int> (ExitCodes::Failure);
+    }
+
+  m_server = new qup_benchmark_server(m_directory.path(), nullptr);
+  m_server->set_conditions(m_conditions);
+
+  auto const port = m_server->port();
+
+  if(port == 0)
+    {
+      stream << tr("The server cannot listen.") << "\n";
+      return static_cast<int> (ExitCodes::Failure);
+    }
+
+  if(!generate(m_directory.path() + QDir::separator() + "product", port))
+    {
+      stream << tr("The product cannot be generated.") << "\n";
+      return static_cast<int> (ExitCodes::Failure);
+    }
+
+  m_budget = new qup_budget(m_connections, m_disk_workers, 0, this);
+  m_updater = new qup_updater(nullptr);
+  m_updater->set_budget(m_budget);
+  connect(m_updater,
+	  &qup_updater::downloads_finished,
+	  this,
+	  &qup_benchmark::slot_downloads_finished);
+  connect(m_updater,
+	  &qup_updater::finished,
+	  this,
+	  &qup_benchmark::slot_finished);
+  connect(m_updater,
+	  &qup_updater::instruction_file_saved,
+	  this,
+	  &qup_benchmark::slot_instruction_file_saved);
+
+  qup_updater::Favorite favorite;
+
+  favorite.m_destination = m_directory.path() +
+    QDir::separator() +
+    "destination";
+  favorite.m_install_automatically = true;
+  favorite.m_install_pipelined = m_install_pipelined;
+  favorite.m_name = "Benchmark";
+  favorite.m_url = QUrl
+    (QString("http://127.0.0.1:%1/product/qup.txt").arg(port));
+  QTimer::singleShot(0, this, [this, favorite](void)
+			      {
+				m_timer.start();
+				m_updater->download(favorite);
+			      });
+
+  if(m_deadline > 0)
+    QTimer::singleShot(m_deadline, this, &qup_benchmark::slot_deadline);
+
+  return QCoreApplication::exec();
+}
+
+int qup_benchmark::micro(void)
+{
+  /*
+  ** The helpers of the hot paths are measured in isolation over
+  ** inputs which resemble the generated product. The fastest of
+  ** s_rounds rounds is reported. A helper regresses if it exceeds
+  ** its baseline by more than the tolerance.
+  */
+
+  QByteArray manifest("[General]\n");
+  QJsonObject helpers;
+  QJsonObject object;
+  QRandomGenerator generator(m_seed);
+  QStringList regressions;
+  QVector<QString> paths;
+  QVector<QString> urls;
+  QVector<quint16> permissions;
+  auto const measure = [&helpers]
+    (const char *name,
+     const int iterations,
+     const std::function<void (const int)> &function)
+    {
+      QJsonObject helper;
+      auto best = std::numeric_limits<qint64>::max();
+
+      for(int i = 0; i < s_rounds; i++)
+	{
+	  QElapsedTimer timer;
+
+	  timer.start();
+
+	  for(int j = 0; j < iterations; j++)
+	    function(j);
+
+	  best = qMin(best, timer.nsecsElapsed());
+	}
+
+      helper["calls"] = iterations;
+      helper["ns_per_call"] =
+	static_cast<double> (best) / static_cast<double> (iterations);
+      helpers[name] = helper;
+    };
+  qint64 checksum = 0;
+
+  for(int i = 0; i < m_files; i++)
+    {
+      auto const path(relative_path(i));
+
+      manifest.append(QString("file = %1\n").arg(path).toUtf8());
+      paths << m_directory.path() + QDir::separator() + path;
+      permissions << static_cast<quint16> (generator.bounded(0x8000));
+      urls << QString("https://127.0.0.1//product//%1").arg(path);
+    }
+
+  manifest.append("url = https://127.0.0.1/product\n");
+  measure("parse_instructions",
+	  qMax(1, m_iterations / m_files),
+	  [&checksum, &manifest](const int)
+	  {
+	    QTextStream stream(manifest);
+
+	    qup_updater::parse_instructions
+	      (stream,
+	       "",
+	       [&checksum]
+	       (const QHash<QString, qup_updater::FileInformation> &files,
+		const QString &,
+		const QString &,
+		const QUrl &)
+	       {
+		 checksum += files.size();
+	       });
+	  });
+  measure("permissions_as_string",
+	  m_iterations,
+	  [&checksum, &permissions](const int i)
+	  {
+	    checksum += qup_files::permissions_as_string
+	      (permissions.at(i % permissions.size())).size();
+	  });
+  measure("proper_path",
+	  m_iterations,
+	  [&checksum, &paths](const int i)
+	  {
+	    checksum += qup_installer::proper_path
+	      (paths.at(i % paths.size())).size();
+	  });
+  measure("string_as_url",
+	  m_iterations,
+	  [&checksum, &urls](const int i)
+	  {
+	    checksum += qup_updater::string_as_url
+	      (urls.at(i % urls.size())).path().size();
+	  });
+
+  if(!m_baseline.isEmpty())
+    {
+      QFile file(m_baseline);
+
+      if(!file.open(QIODevice::ReadOnly))
+	{
+	  QTextStream(stderr) << tr("Cannot read %1. A baseline is recorded "
+				    "by the micro_baseline target of the "
+				    "Makefile.").arg(m_baseline)
+			      << "\n";
+	  return static_cast<int> (ExitCodes::Failure);
+	}
+
+      auto const baseline
+	(QJsonDocument::fromJson(file.readAll()).object().
+	 value("helpers").toObject());
+
+      foreach(auto const &name, helpers.keys())
+	{
+	  auto const after = helpers.value(name).toObject().
+	    value("ns_per_call").toDouble();
+	  auto const before = baseline.value(name).toObject().
+	    value("ns_per_call").toDouble();
+
+	  if(before > 0.0 &&
+	     after > before * (1.0 + static_cast<double> (m_tolerance) / 100.0))
+	    regressions << name;
+	}
+    }
+
+  object["baseline"] = m_baseline;
+  object["checksum"] = checksum;
+  object["files"] = m_files;
+  object["helpers"] = helpers;
+  object["iterations"] = m_iterations;
+  object["passed"] = regressions.isEmpty();
+  object["regressions"] = QJsonArray::fromStringList(regressions);
+  object["rounds"] = s_rounds;
+  object["seed"] = static_cast<qint64> (m_seed);
+  object["tolerance_percent"] = m_tolerance;
+  object["version"] = qup::VERSION;
+  return static_cast<int>
+    (write(object) && regressions.isEmpty() ?
+     ExitCodes::Success : ExitCodes::Failure);
+}
+
+qint64 qup_benchmark::installed(const QString &directory) const
+{
+  /*
+  ** Only the generated files are counted. The instruction file is
+  ** installed beside them.
+  */
+
+  qint64 count = 0;
+
+  for(int i = 0; i < m_files; i++)
+    if(QFileInfo(directory + QDir::separator() + relative_path(i)).isFile())
+      count += 1;
+
+  return count;
+}
+
+void qup_benchmark::gather(const QString &directory) const
+{
+  /*
+  ** Every installed file is digested as a page does after an update.
+  */
+
+  QDirIterator it(directory, QDir::Files, QDirIterator::Subdirectories);
+
+  while(it.hasNext())
+    qup_files::file_digest(it.next());
+}
+
+void qup_benchmark::report(const bool ok,
+			   const bool timed_out,
+			   const qint64 gather_time,
+			   const qint64 installed_files)
+{
+  QJsonObject conditions;
+  QJsonObject object;
+  QJsonObject phases;
+  QJsonObject resources;
+
+  auto const passed = !timed_out &&
+    ok == m_expect_success &&
+    (!ok || installed_files == m_files) &&
+    (m_deadline <= 0 || m_timer.elapsed() <= m_deadline);
+
+  conditions["bandwidth_cap"] = m_conditions.m_bandwidth;
+  conditions["error_burst"] = m_conditions.m_error_burst;
+  conditions["error_rate"] = m_conditions.m_error_rate;
+  conditions["first_byte_ms"] = m_conditions.m_first_byte;
+  conditions["latency_ms"] = m_conditions.m_latency;
+  conditions["reset_rate"] = m_conditions.m_reset_rate;
+  phases["download"] = m_download_time;
+  phases["gather"] = gather_time;
+  phases["install"] = m_install_time;
+  phases["manifest"] = m_manifest_time;
+  object["bytes"] = m_bytes;
+  object["bytes_per_second"] = m_download_time > 0 ?
+    1000.0 * static_cast<double> (m_bytes) /
+    static_cast<double> (m_download_time) : 0.0;
+  object["conditions"] = conditions;
+  object["connections"] = m_connections;
+  object["deadline_ms"] = m_deadline;
+  object["depth"] = m_depth;
+  object["disk_workers"] = m_disk_workers;
+  object["expected"] = m_expect_success ? "success" : "failure";
+  object["files"] = m_files;
+  object["installed_files"] = installed_files;
+  object["maximum_size"] = m_maximum_size;
+  object["metrics"] = m_updater->metrics()->json("Benchmark");
+  object["minimum_size"] = m_minimum_size;
+  object["ok"] = ok;
+  object["passed"] = passed;
+  object["phases_ms"] = phases;
+  object["pipelined"] = m_install_pipelined;
+  object["resets"] = m_server->resets();
+  object["scenario"] = m_scenario;
+  object["seed"] = static_cast<qint64> (m_seed);
+  object["served_bytes"] = m_server->served_bytes();
+  object["server_errors"] = m_server->server_errors();
+  object["timed_out"] = timed_out;
+  object["version"] = qup::VERSION;
+  object["wall_ms"] = m_timer.elapsed();
+
+#ifdef Q_OS_UNIX
+  struct rusage usage = {};
+
+  if(getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef Q_OS_MACOS
+      resources["peak_rss_kib"] = static_cast<qint64> (usage.ru_maxrss / 1024);
+#else
+      resources["peak_rss_kib"] = static_cast<qint64> (usage.ru_maxrss);
+#endif
+      resources["involuntary_context_switches"] =
+	static_cast<qint64> (usage.ru_nivcsw);
+      resources["system_cpu_ms"] = static_cast<qint64>
+	(usage.ru_stime.tv_sec * 1000 + usage.ru_stime.tv_usec / 1000);
+      resources["user_cpu_ms"] = static_cast<qint64>
+	(usage.ru_utime.tv_sec * 1000 + usage.ru_utime.tv_usec / 1000);
+      resources["voluntary_context_switches"] =
+	static_cast<qint64> (usage.ru_nvcsw);
+    }
+#endif
+
+  /*
+  ** The read and write system calls are counted by Linux.
+  */
+
+  QFile io("/proc/self/io");
+
+  if(io.open(QIODevice::ReadOnly | QIODevice::Text))
+    foreach(auto const &line, io.readAll().split('\n'))
+      if(line.startsWith("syscr:"))
+	resources["read_syscalls"] = line.mid(6).trimmed().toLongLong();
+      else if(line.startsWith("syscw:"))
+	resources["write_syscalls"] = line.mid(6).trimmed().toLongLong();
+
+  object["resources"] = resources;
+
+  write(object);
+  QCoreApplication::exit
+    (static_cast<int> (passed ? ExitCodes::Success : ExitCodes::Failure));
+}
+
+void qup_benchmark::slot_deadline(void)
+{
+  /*
+  ** An interrupted update does not finish.
+  */
+
+  if(!m_updater || !m_updater->active())
+    return;
+
+  m_updater->interrupt();
+  report(false, true, 0, 0);
+}
+
+void qup_benchmark::slot_downloads_finished(void)
+{
+  m_download_time = m_timer.elapsed() - m_manifest_time;
+}
+
+void qup_benchmark::slot_finished(const bool ok)
+{
+  m_install_time = m_timer.elapsed() - m_download_time - m_manifest_time;
+
+  QElapsedTimer timer;
+
+  timer.start();
+
+  auto const destination
+    (m_directory.path() + QDir::separator() + "destination");
+
+  gather(destination);
+  report(ok, false, timer.elapsed(), installed(destination));
+}
+
+void qup_benchmark::slot_instruction_file_saved(void)
+{
+  m_manifest_time = m_timer.elapsed();
+}
@@ -0,0 +1,114 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_benchmark_h_
+#define _qup_benchmark_h_
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include "qup_benchmark_server.h"
+
+class qup_budget;
+class qup_updater;
+
+/*
+** Measures an update of a synthetic product which is published by
+** an in-process HTTP server. The product's files are generated from
+** a seed so that runs are comparable. The server may imitate a poor
+** link. A run passes if its outcome is the expected outcome and if it
+** completes before the deadline. The result is written as JSON.
+** Alternatively, --micro measures the helpers of the hot paths and
+** compares them with a prior result.
+*/
+
+class qup_benchmark: public QObject
+{
+  Q_OBJECT
+
+ public:
+  enum class ExitCodes
+  {
+    Failure = 2,
+    Success = 0,
+    Usage = 1
+  };
+
+  qup_benchmark(QObject *parent);
+  ~qup_benchmark();
+  static bool requested(int argc, char *argv[]);
+  int exec(void);
+
+ private:
+  QElapsedTimer m_timer;
+  QString m_baseline;
+  QString m_output;
+  QString m_scenario;
+  QTemporaryDir m_directory;
+  bool m_expect_success;
+  bool m_install_pipelined;
+  bool m_micro;
+  int m_connections;
+  int m_depth;
+  int m_disk_workers;
+  int m_files;
+  int m_iterations;
+  int m_tolerance; // Percent.
+  qint64 m_bytes;
+  qint64 m_deadline; // Milliseconds, zero is none.
+  qint64 m_download_time; // Milliseconds.
+  qint64 m_install_time; // Milliseconds.
+  qint64 m_manifest_time; // Milliseconds.
+  qint64 m_maximum_size; // Bytes.
+  qint64 m_minimum_size; // Bytes.
+  quint32 m_seed;
+  qup_benchmark_server *m_server;
+  qup_benchmark_server::Conditions m_conditions;
+  qup_budget *m_budget;
+  qup_updater *m_updater;
+  QString relative_path(const int index) const;
+  bool generate(const QString &directory, const quint16 port);
+  bool parse(const QStringList &arguments);
+  bool scenario(const QString &name);
+  bool write(const QJsonObject &object) const;
+  int micro(void);
+  qint64 installed(const QString &directory) const;
+  void gather(const QString &directory) const;
+  void report(const bool ok,
+	      const bool timed_out,
+	      const qint64 gather_time,
+	      const qint64 installed_files);
+
+ private slots:
+  void slot_deadline(void);
+  void slot_downloads_finished(void);
+  void slot_finished(const bool ok);
+  void slot_instruction_file_saved(void);
+};
+
+#endif
@@ -0,0 +1,321 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+
+#include "qup_benchmark_server.h"
+
+const int static s_burst = 100; // Milliseconds of bandwidth.
+const int static s_tick = 10; // Milliseconds.
+
+qup_benchmark_server::qup_benchmark_server
+(const QString &root, QObject *parent):QThread(parent)
+{
+  m_errors = 0;
+  m_port = 0;
+  m_resets.storeRelease(0);
+  m_root = QDir::cleanPath(root);
+  m_served_bytes.storeRelease(0);
+  m_server_errors.storeRelease(0);
+  m_timer = nullptr;
+}
+
+qup_benchmark_server::~qup_benchmark_server()
+{
+  quit();
+  wait();
+}
+
+qint64 qup_benchmark_server::resets(void) const
+{
+  return m_resets.loadAcquire();
+}
+
+qint64 qup_benchmark_server::served_bytes(void) const
+{
+  return m_served_bytes.loadAcquire();
+}
+
+qint64 qup_benchmark_server::server_errors(void) const
+{
+  return m_server_errors.loadAcquire();
+}
+
+quint16 qup_benchmark_server::port(void)
+{
+  /*
+  ** Starts the server if necessary and waits until it is listening.
+  ** Zero is returned if the server could not listen.
+  */
+
+  if(!isRunning())
+    {
+      start();
+      m_ready.acquire();
+    }
+
+  return m_port;
+}
+
+void qup_benchmark_server::enqueue(QTcpSocket *socket,
+				   const QByteArray &header,
+				   const QByteArray &body)
+{
+  /*
+  ** A response is delivered after the latency. Its body follows after
+  ** the first-byte delay and may be interrupted.
+  */
+
+  auto &connection(m_connections[socket]);
+  Segment segment;
+
+  segment.m_data = header;
+  segment.m_delay = m_conditions.m_latency;
+  segment.m_reset_at = -1;
+  segment.m_start = -1;
+  connection.m_output.enqueue(segment);
+
+  if(!body.isEmpty())
+    {
+      segment.m_data = body;
+      segment.m_delay = m_conditions.m_first_byte;
+      segment.m_reset_at =
+	m_conditions.m_reset_rate > 0 &&
+	m_random.bounded(100) < m_conditions.m_reset_rate ?
+	m_random.bounded(body.size()) : -1;
+      connection.m_output.enqueue(segment);
+    }
+}
+
+void qup_benchmark_server::respond(QTcpSocket *socket)
+{
+  auto &input(m_connections[socket].m_input);
+
+  input.append(socket->readAll());
+
+  int index = -1;
+
+  while((index = input.indexOf("\r\n\r\n")) >= 0)
+    {
+      auto const lines(input.mid(0, index).split('\n'));
+      auto const line(lines.value(0).trimmed().split(' '));
+
+      input.remove(0, index + 4);
+
+      if(m_conditions.m_error_burst > 0 &&
+	 m_errors == 0 &&
+	 m_random.bounded(100) < m_conditions.m_error_rate)
+	m_errors = m_conditions.m_error_burst;
+
+      if(m_errors > 0)
+	{
+	  m_errors -= 1;
+	  m_server_errors.fetchAndAddOrdered(1);
+	  enqueue(socket,
+		  "HTTP/1.1 503 Service Unavailable\r\n"
+		  "Content-Length: 0\r\n"
+		  "\r\n",
+		  "");
+	  continue;
+	}
+
+      auto const path
+	(QUrl::fromPercentEncoding(line.value(1)).split('?').value(0));
+      QFile file(QDir::cleanPath(m_root + "/" + path));
+
+      if(line.value(0) != "GET" ||
+	 path.contains("..") ||
+	 !QFileInfo(file.fileName()).isFile() ||
+	 !file.open(QIODevice::ReadOnly))
+	{
+	  enqueue(socket,
+		  "HTTP/1.1 404 Not Found\r\n"
+		  "Content-Length: 0\r\n"
+		  "\r\n",
+		  "");
+	  continue;
+	}
+
+      auto const data(file.readAll());
+
+      enqueue(socket,
+	      QString("HTTP/1.1 200 OK\r\n"
+		      "Content-Length: %1\r\n"
+		      "Content-Type: application/octet-stream\r\n"
+		      "\r\n").arg(data.size()).toLatin1(),
+	      data);
+    }
+
+  transmit();
+}
+
+void qup_benchmark_server::run(void)
+{
+  QTcpServer server;
+  QTimer timer;
+
+  connect(&server,
+	  &QTcpServer::newConnection,
+	  &server,
+	  [this, &server](void)
+	  {
+	    while(server.hasPendingConnections())
+	      {
+		auto socket = server.nextPendingConnection();
+
+		m_connections[socket].m_allowance = 0.0;
+		m_connections[socket].m_last = m_clock.elapsed();
+		connect(socket,
+			&QTcpSocket::disconnected,
+			socket,
+			[this, socket](void)
+			{
+			  m_connections.remove(socket);
+			  socket->deleteLater();
+			});
+		connect(socket,
+			&QTcpSocket::readyRead,
+			socket,
+			[this, socket](void)
+			{
+			  respond(socket);
+			});
+	      }
+	  });
+  connect(&timer,
+	  &QTimer::timeout,
+	  &timer,
+	  [this](void)
+	  {
+	    transmit();
+	  });
+  m_clock.start();
+  m_timer = &timer;
+  m_timer->setInterval(s_tick);
+  m_port = server.listen(QHostAddress::LocalHost, 0) ?
+    server.serverPort() : 0;
+  m_ready.release();
+
+  if(m_port > 0)
+    exec();
+
+  m_connections.clear();
+  m_timer = nullptr;
+}
+
+void qup_benchmark_server::set_conditions(const Conditions &conditions)
+{
+  /*
+  ** Must be issued before the server is started.
+  */
+
+  m_conditions = conditions;
+  m_random.seed(m_conditions.m_seed);
+}
+
+void qup_benchmark_server::transmit(void)
+{
+  QList<QTcpSocket *> resets;
+  auto const bandwidth = static_cast<double> (m_conditions.m_bandwidth);
+  auto const now = m_clock.elapsed();
+  auto pending = false;
+
+  for(auto it = m_connections.begin(); it != m_connections.end(); ++it)
+    {
+      auto &connection(it.value());
+
+      if(bandwidth > 0.0)
+	connection.m_allowance = qMin
+	  (bandwidth * s_burst / 1000.0,
+	   connection.m_allowance +
+	   bandwidth * static_cast<double> (now - connection.m_last) / 1000.0);
+
+      connection.m_last = now;
+
+      while(!connection.m_output.isEmpty())
+	{
+	  auto &segment(connection.m_output.head());
+
+	  if(segment.m_start < 0)
+	    segment.m_start = now + segment.m_delay;
+
+	  if(now < segment.m_start)
+	    break;
+
+	  auto size = static_cast<qint64> (segment.m_data.size());
+
+	  if(bandwidth > 0.0)
+	    size = qMin(size, static_cast<qint64> (connection.m_allowance));
+
+	  if(segment.m_reset_at >= 0)
+	    size = qMin(size, segment.m_reset_at);
+
+	  if(size > 0)
+	    {
+	      it.key()->write(segment.m_data.constData(), size);
+	      connection.m_allowance -= static_cast<double> (size);
+	      m_served_bytes.fetchAndAddOrdered(size);
+	      segment.m_data.remove(0, static_cast<int> (size));
+	      segment.m_reset_at -= segment.m_reset_at >= 0 ? size : 0;
+	    }
+
+	  if(segment.m_reset_at == 0)
+	    {
+	      resets << it.key();
+	      break;
+	    }
+
+	  if(!segment.m_data.isEmpty())
+	    break;
+
+	  connection.m_output.dequeue();
+	}
+
+      pending = pending || !connection.m_output.isEmpty();
+    }
+
+  foreach(auto socket, resets)
+    {
+      m_connections[socket].m_output.clear();
+      m_resets.fetchAndAddOrdered(1);
+      socket->abort();
+    }
+
+  if(m_timer)
+    {
+      if(!pending)
+	m_timer->stop();
+      else if(!m_timer->isActive())
+	m_timer->start();
+    }
+}
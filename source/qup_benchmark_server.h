@@ -0,0 +1,124 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_benchmark_server_h_
+#define _qup_benchmark_server_h_
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QQueue>
+#include <QRandomGenerator>
+#include <QSemaphore>
+#include <QThread>
+
+class QTcpSocket;
+class QTimer;
+
+/*
+** A minimal HTTP/1.1 server which publishes the files below a root
+** directory on the loopback interface. It executes in its own thread
+** so that it does not compete with the client's event loop. Traffic
+** may be shaped per connection in order to imitate poor links.
+*/
+
+class qup_benchmark_server: public QThread
+{
+  Q_OBJECT
+
+ public:
+  class Conditions
+  {
+  public:
+    Conditions(void)
+    {
+      m_bandwidth = 0;
+      m_error_burst = 0;
+      m_error_rate = 0;
+      m_first_byte = 0;
+      m_latency = 0;
+      m_reset_rate = 0;
+      m_seed = 1;
+    }
+
+    int m_error_burst; // Consecutive 503 responses.
+    int m_error_rate; // Percent of requests which begin a burst.
+    int m_first_byte; // Milliseconds between the header and the body.
+    int m_latency; // Milliseconds before every response.
+    int m_reset_rate; // Percent of bodies which are interrupted.
+    qint64 m_bandwidth; // Bytes per second per connection, zero is unlimited.
+    quint32 m_seed;
+  };
+
+  qup_benchmark_server(const QString &root, QObject *parent);
+  ~qup_benchmark_server();
+  qint64 resets(void) const;
+  qint64 served_bytes(void) const;
+  qint64 server_errors(void) const;
+  quint16 port(void);
+  void set_conditions(const Conditions &conditions);
+
+ private:
+  class Segment
+  {
+  public:
+    QByteArray m_data;
+    int m_delay; // Milliseconds.
+    qint64 m_reset_at; // Offset, -1 if the segment is delivered.
+    qint64 m_start; // Server clock, -1 until the segment is reached.
+  };
+
+  class Connection
+  {
+  public:
+    QByteArray m_input;
+    QQueue<Segment> m_output;
+    double m_allowance; // Bytes.
+    qint64 m_last; // Server clock.
+  };
+
+  Conditions m_conditions;
+  QAtomicInteger<qint64> m_resets;
+  QAtomicInteger<qint64> m_served_bytes;
+  QAtomicInteger<qint64> m_server_errors;
+  QElapsedTimer m_clock;
+  QHash<QTcpSocket *, Connection> m_connections;
+  QRandomGenerator m_random;
+  QSemaphore m_ready;
+  QString m_root;
+  QTimer *m_timer;
+  int m_errors;
+  quint16 m_port;
+  void enqueue(QTcpSocket *socket,
+	       const QByteArray &header,
+	       const QByteArray &body);
+  void respond(QTcpSocket *socket);
+  void run(void);
+  void transmit(void);
+};
+
+#endif
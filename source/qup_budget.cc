@@ -0,0 +1,117 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "qup_budget.h"
+
+qup_budget::qup_budget(const int connections,
+		       const int disk_workers,
+		       const qint64 bandwidth,
+		       QObject *parent):QObject(parent),
+					m_disk_workers(qMax(1, disk_workers))
+{
+  m_bandwidth = qMax(static_cast<qint64> (0), bandwidth);
+  m_connections = 0;
+  m_last = 0;
+  m_maximum_connections = qMax(1, connections);
+  m_timer.start();
+  m_tokens = m_bandwidth;
+}
+
+QSemaphore *qup_budget::disk_workers(void)
+{
+  return &m_disk_workers;
+}
+
+bool qup_budget::acquire_connection(void)
+{
+  if(m_connections >= m_maximum_connections)
+    return false;
+
+  m_connections += 1;
+  return true;
+}
+
+qint64 qup_budget::bandwidth(void) const
+{
+  return m_bandwidth;
+}
+
+qint64 qup_budget::take(const qint64 bytes)
+{
+  /*
+  ** Grant at most the available tokens.
+  */
+
+  if(bytes <= 0 || m_bandwidth <= 0)
+    return qMax(static_cast<qint64> (0), bytes);
+
+  refill();
+
+  auto const granted = qBound(static_cast<qint64> (0), bytes, m_tokens);
+
+  m_tokens -= granted;
+  return granted;
+}
+
+void qup_budget::charge(const qint64 bytes)
+{
+  /*
+  ** Bytes which could not be deferred. The debt is repaid later.
+  */
+
+  if(bytes <= 0 || m_bandwidth <= 0)
+    return;
+
+  refill();
+  m_tokens -= bytes;
+}
+
+void qup_budget::refill(void)
+{
+  /*
+  ** A bucket of one second. The clock advances only if tokens are
+  ** added so that frequent calls are not starved.
+  */
+
+  auto const elapsed = qMin
+    (static_cast<qint64> (1000000000), m_timer.nsecsElapsed() - m_last);
+  auto const tokens = m_bandwidth * elapsed / 1000000000;
+
+  if(tokens > 0)
+    {
+      m_last = m_timer.nsecsElapsed();
+      m_tokens = qMin(m_bandwidth, m_tokens + tokens);
+    }
+}
+
+void qup_budget::release_connection(void)
+{
+  if(m_connections > 0)
+    m_connections -= 1;
+
+  emit connection_released();
+}
@@ -0,0 +1,72 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_budget_h_
+#define _qup_budget_h_
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSemaphore>
+
+/*
+** A budget shared by concurrent updates: network connections, disk
+** workers, and bandwidth (bytes per second, zero is unlimited).
+** Connections and bandwidth are consumed by the main thread; disk
+** workers by any thread.
+*/
+
+class qup_budget: public QObject
+{
+  Q_OBJECT
+
+ public:
+  qup_budget(const int connections,
+	     const int disk_workers,
+	     const qint64 bandwidth,
+	     QObject *parent);
+  QSemaphore *disk_workers(void);
+  bool acquire_connection(void);
+  qint64 bandwidth(void) const;
+  qint64 take(const qint64 bytes);
+  void charge(const qint64 bytes);
+  void release_connection(void);
+
+ private:
+  QElapsedTimer m_timer;
+  QSemaphore m_disk_workers;
+  int m_connections;
+  int m_maximum_connections;
+  qint64 m_bandwidth;
+  qint64 m_last; // Nanoseconds.
+  qint64 m_tokens;
+  void refill(void);
+
+ signals:
+  void connection_released(void);
+};
+
+#endif
@@ -0,0 +1,207 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QFileInfo>
+#include <QSettings>
+
+#include "qup_favorites.h"
+
+const int static s_reload_interval = 250; // Milliseconds.
+
+qup_favorites::qup_favorites(QObject *parent):QObject(parent)
+{
+  connect(&m_reload_timer,
+	  &QTimer::timeout,
+	  this,
+	  &qup_favorites::slot_reload);
+  connect(&m_watcher,
+	  &QFileSystemWatcher::fileChanged,
+	  this,
+	  &qup_favorites::slot_file_changed);
+  m_favorites = read();
+  m_reload_timer.setInterval(s_reload_interval);
+  m_reload_timer.setSingleShot(true);
+  watch();
+}
+
+QMap<QString, QVariantMap> qup_favorites::read(void)
+{
+  QMap<QString, QVariantMap> favorites;
+  QSettings settings;
+
+  settings.sync();
+
+  foreach(auto const &group, settings.childGroups())
+    if(group.startsWith("favorite-"))
+      {
+	QVariantMap values;
+
+	settings.beginGroup(group);
+
+	foreach(auto const &key, settings.childKeys())
+	  values[key] = settings.value(key);
+
+	settings.endGroup();
+	values = normalized(values);
+
+	auto const name(values.value("name").toString().trimmed());
+
+	if(!name.isEmpty())
+	  favorites[name] = values;
+      }
+
+  return favorites;
+}
+
+QStringList qup_favorites::names(void) const
+{
+  return m_favorites.keys();
+}
+
+QVariantMap qup_favorites::normalized(const QVariantMap &values)
+{
+  /*
+  ** Values are retained as the INI file presents them, as strings, so
+  ** that saved and reloaded favorites compare equal.
+  */
+
+  QVariantMap map;
+
+  for(auto it = values.constBegin(); it != values.constEnd(); ++it)
+    map[it.key()] = it.value().toString();
+
+  return map;
+}
+
+QVariantMap qup_favorites::values(const QString &name) const
+{
+  return m_favorites.value(name);
+}
+
+bool qup_favorites::contains(const QString &name) const
+{
+  return m_favorites.contains(name);
+}
+
+bool qup_favorites::remove(const QString &name)
+{
+  QSettings settings;
+
+  settings.beginGroup(QString("favorite-%1").arg(name));
+  settings.remove("");
+  settings.endGroup(); // Optional.
+  settings.sync();
+
+  if(settings.status() != QSettings::NoError)
+    return false;
+
+  if(m_favorites.remove(name) > 0)
+    emit removed(name);
+
+  watch();
+  return true;
+}
+
+bool qup_favorites::save(const QString &name, const QVariantMap &values)
+{
+  QSettings settings;
+
+  settings.beginGroup(QString("favorite-%1").arg(name));
+
+  for(auto it = values.constBegin(); it != values.constEnd(); ++it)
+    settings.setValue(it.key(), it.value());
+
+  settings.endGroup();
+  settings.sync();
+
+  if(settings.status() != QSettings::NoError)
+    return false;
+
+  auto const contained = m_favorites.contains(name);
+  auto merged(m_favorites.value(name));
+
+  for(auto it = values.constBegin(); it != values.constEnd(); ++it)
+    merged[it.key()] = it.value().toString();
+
+  if(!contained)
+    {
+      m_favorites[name] = merged;
+      emit added(name);
+    }
+  else if(m_favorites.value(name) != merged)
+    {
+      m_favorites[name] = merged;
+      emit changed(name);
+    }
+
+  watch();
+  return true;
+}
+
+void qup_favorites::slot_file_changed(const QString &path)
+{
+  Q_UNUSED(path);
+
+  /*
+  ** Editors and QSettings replace the file, so several notifications
+  ** may arrive for one edit.
+  */
+
+  m_reload_timer.start();
+}
+
+void qup_favorites::slot_reload(void)
+{
+  auto const favorites(read());
+  auto const previous(m_favorites);
+
+  m_favorites = favorites;
+
+  for(auto it = previous.constBegin(); it != previous.constEnd(); ++it)
+    if(!favorites.contains(it.key()))
+      emit removed(it.key());
+
+  for(auto it = favorites.constBegin(); it != favorites.constEnd(); ++it)
+    if(!previous.contains(it.key()))
+      emit added(it.key());
+    else if(previous.value(it.key()) != it.value())
+      emit changed(it.key());
+
+  watch();
+}
+
+void qup_favorites::watch(void)
+{
+  /*
+  ** A replaced file is no longer watched.
+  */
+
+  auto const file_name(QSettings().fileName());
+
+  if(QFileInfo(file_name).exists() && !m_watcher.files().contains(file_name))
+    m_watcher.addPath(file_name);
+}
@@ -0,0 +1,72 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_favorites_h_
+#define _qup_favorites_h_
+
+#include <QFileSystemWatcher>
+#include <QMap>
+#include <QTimer>
+#include <QVariantMap>
+
+/*
+** The favorites of the Qup INI file, read once and retained in memory.
+** The file is watched for external edits. Listeners are informed of
+** individual additions, changes, and removals.
+*/
+
+class qup_favorites: public QObject
+{
+  Q_OBJECT
+
+ public:
+  qup_favorites(QObject *parent);
+  QStringList names(void) const;
+  QVariantMap values(const QString &name) const;
+  bool contains(const QString &name) const;
+  bool remove(const QString &name);
+  bool save(const QString &name, const QVariantMap &values);
+
+ private:
+  QFileSystemWatcher m_watcher;
+  QMap<QString, QVariantMap> m_favorites;
+  QTimer m_reload_timer;
+  static QMap<QString, QVariantMap> read(void);
+  static QVariantMap normalized(const QVariantMap &values);
+  void watch(void);
+
+ private slots:
+  void slot_file_changed(const QString &path);
+  void slot_reload(void);
+
+ signals:
+  void added(const QString &name);
+  void changed(const QString &name);
+  void removed(const QString &name);
+};
+
+#endif
@@ -0,0 +1,423 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+
+#include <cstring>
+
+#include "qup_files.h"
+
+class qup_cached_digest
+{
+ public:
+  qup_file_digest m_digest;
+  qint64 m_modified;
+  qint64 m_size;
+};
+
+/*
+** Digests are remembered while files retain their sizes and modification
+** times. Shared by the gatherers and the installers.
+*/
+
+QHash<QString, qup_cached_digest> static s_digests;
+QMutex static s_digests_mutex;
+const int static s_maximum_cached_digests = 65536;
+
+qup_files::qup_files(void)
+{
+}
+
+QSet<int> qup_files::category(const Categories category) const
+{
+  auto const i = static_cast<int> (category);
+
+  if(i < 0 || i >= static_cast<int> (Categories::XYZ))
+    return QSet<int> ();
+
+  return m_categories[i];
+}
+
+QString qup_files::digest_as_string(const qup_file_digest &digest)
+{
+  return QByteArray::fromRawData
+    (reinterpret_cast<const char *> (digest.data()),
+     static_cast<int> (digest.size())).toHex();
+}
+
+QString qup_files::local_digest(const int slot) const
+{
+  if(!contains(slot) || (m_flags.at(slot) & qup_file::LocalMissing))
+    return "";
+
+  return digest_as_string(m_local_digests.at(slot));
+}
+
+QString qup_files::local_file_name(const int slot) const
+{
+  if(!contains(slot))
+    return "";
+
+  return QDir::cleanPath
+    (m_destination_path + QDir::separator() + relative_path(slot));
+}
+
+QString qup_files::local_permissions(const int slot) const
+{
+  if(!contains(slot) || (m_flags.at(slot) & qup_file::LocalMissing))
+    return "";
+
+  return permissions_as_string(m_local_permissions.at(slot));
+}
+
+QString qup_files::permissions_as_string(const quint16 permissions)
+{
+  /*
+  ** Owner:Group:Other. See QFileDevice::Permission.
+  */
+
+  char string[] = "---:---:---";
+
+  if(permissions & 0x4000)
+    string[0] = 'r';
+
+  if(permissions & 0x2000)
+    string[1] = 'w';
+
+  if(permissions & 0x1000)
+    string[2] = 'x';
+
+  if(permissions & 0x0040)
+    string[4] = 'r';
+
+  if(permissions & 0x0020)
+    string[5] = 'w';
+
+  if(permissions & 0x0010)
+    string[6] = 'x';
+
+  if(permissions & 0x0004)
+    string[8] = 'r';
+
+  if(permissions & 0x0002)
+    string[9] = 'w';
+
+  if(permissions & 0x0001)
+    string[10] = 'x';
+
+  return QString::fromLatin1(string, static_cast<int> (sizeof(string) - 1));
+}
+
+QString qup_files::relative_path(const int slot) const
+{
+  if(!contains(slot))
+    return "";
+
+  auto const directory(m_directories.value(m_directory.at(slot)));
+
+  if(directory.isEmpty())
+    return m_names.at(slot);
+  else
+    return directory + '/' + m_names.at(slot);
+}
+
+QString qup_files::temporary_digest(const int slot) const
+{
+  if(!contains(slot) || (m_flags.at(slot) & qup_file::TemporaryMissing))
+    return "";
+
+  return digest_as_string(m_temporary_digests.at(slot));
+}
+
+QString qup_files::temporary_file_name(const int slot) const
+{
+  if(!contains(slot))
+    return "";
+
+  return QDir::cleanPath
+    (m_local_path + QDir::separator() + relative_path(slot));
+}
+
+QString qup_files::temporary_permissions(const int slot) const
+{
+  if(!contains(slot) || (m_flags.at(slot) & qup_file::TemporaryMissing))
+    return "";
+
+  return permissions_as_string(m_temporary_permissions.at(slot));
+}
+
+bool qup_files::contains(const int slot) const
+{
+  return slot >= 0 && slot < m_directory.size() && m_directory.at(slot) >= 0;
+}
+
+bool qup_files::in_category(const int slot, const Categories category) const
+{
+  auto const i = static_cast<int> (category);
+
+  if(i < 0 || i >= static_cast<int> (Categories::XYZ))
+    return false;
+
+  return m_categories[i].contains(slot);
+}
+
+bool qup_files::mismatched(const int slot) const
+{
+  return in_category(slot, Categories::Mismatched) ||
+    in_category(slot, Categories::Missing);
+}
+
+bool qup_files::set_paths
+(const QString &destination_path, const QString &local_path)
+{
+  if(destination_path == m_destination_path && local_path == m_local_path)
+    return false;
+
+  m_destination_path = destination_path;
+  m_local_path = local_path;
+  return true;
+}
+
+int qup_files::count(void) const
+{
+  return m_slots.size();
+}
+
+int qup_files::intern(const QString &directory)
+{
+  auto const identifier = m_directory_identifiers.value(directory, -1);
+
+  if(identifier >= 0)
+    return identifier;
+
+  m_directories << directory;
+  m_directory_identifiers[directory] = m_directories.size() - 1;
+  return m_directories.size() - 1;
+}
+
+int qup_files::slot(const QString &relative_path) const
+{
+  auto const index = qMax(relative_path.lastIndexOf('/'),
+			  relative_path.lastIndexOf('\\'));
+  auto const identifier = m_directory_identifiers.value
+    (relative_path.mid(0, qMax(0, index)), -1);
+
+  if(identifier < 0)
+    return -1;
+
+  return m_slots.value
+    (qMakePair(identifier, relative_path.mid(index + 1)), -1);
+}
+
+int qup_files::upsert(const qup_file &file, bool *changed)
+{
+  auto const index = qMax(file.m_relative_path.lastIndexOf('/'),
+			  file.m_relative_path.lastIndexOf('\\'));
+  auto const identifier = intern
+    (file.m_relative_path.mid(0, qMax(0, index)));
+  auto const key(qMakePair(identifier, file.m_relative_path.mid(index + 1)));
+  auto slot = m_slots.value(key, -1);
+
+  if(slot >= 0)
+    {
+      auto const c = m_flags.at(slot) != file.m_flags ||
+	m_local_digests.at(slot) != file.m_local_digest ||
+	m_local_permissions.at(slot) != file.m_local_permissions ||
+	m_temporary_digests.at(slot) != file.m_temporary_digest ||
+	m_temporary_permissions.at(slot) != file.m_temporary_permissions;
+
+      if(c)
+	{
+	  m_flags[slot] = file.m_flags;
+	  m_local_digests[slot] = file.m_local_digest;
+	  m_local_permissions[slot] = file.m_local_permissions;
+	  m_temporary_digests[slot] = file.m_temporary_digest;
+	  m_temporary_permissions[slot] = file.m_temporary_permissions;
+	  categorize(slot);
+	}
+
+      if(changed)
+	*changed = c;
+
+      return slot;
+    }
+
+  if(m_free.isEmpty())
+    {
+      slot = m_directory.size();
+      m_directory << identifier;
+      m_flags << file.m_flags;
+      m_local_digests << file.m_local_digest;
+      m_local_permissions << file.m_local_permissions;
+      m_names << key.second;
+      m_temporary_digests << file.m_temporary_digest;
+      m_temporary_permissions << file.m_temporary_permissions;
+    }
+  else
+    {
+      slot = m_free.takeLast();
+      m_directory[slot] = identifier;
+      m_flags[slot] = file.m_flags;
+      m_local_digests[slot] = file.m_local_digest;
+      m_local_permissions[slot] = file.m_local_permissions;
+      m_names[slot] = key.second;
+      m_temporary_digests[slot] = file.m_temporary_digest;
+      m_temporary_permissions[slot] = file.m_temporary_permissions;
+    }
+
+  if(changed)
+    *changed = true;
+
+  m_slots[key] = slot;
+  categorize(slot);
+  return slot;
+}
+
+qup_file qup_files::file(const int slot) const
+{
+  qup_file file;
+
+  if(!contains(slot))
+    return file;
+
+  file.m_flags = m_flags.at(slot);
+  file.m_local_digest = m_local_digests.at(slot);
+  file.m_local_permissions = m_local_permissions.at(slot);
+  file.m_relative_path = relative_path(slot);
+  file.m_temporary_digest = m_temporary_digests.at(slot);
+  file.m_temporary_permissions = m_temporary_permissions.at(slot);
+  return file;
+}
+
+qup_file_digest qup_files::file_digest(const QString &file_name)
+{
+  QFileInfo const file_information(file_name);
+  auto const absolute_file_name(file_information.absoluteFilePath());
+  auto const modified = file_information.lastModified().toMSecsSinceEpoch();
+  auto const size = file_information.size();
+
+  {
+    QMutexLocker locker(&s_digests_mutex);
+    auto const it = s_digests.constFind(absolute_file_name);
+
+    if(it != s_digests.constEnd() &&
+       it->m_modified == modified &&
+       it->m_size == size)
+      return it->m_digest;
+  }
+
+  QCryptographicHash sha3_256(QCryptographicHash::Sha3_256);
+  QFile file(file_name);
+  qup_file_digest digest;
+
+  if(file.open(QIODevice::ReadOnly))
+    {
+      sha3_256.addData(&file);
+      file.close();
+    }
+
+  auto const result(sha3_256.result());
+
+  digest.fill(0);
+  memcpy(digest.data(),
+	 result.constData(),
+	 qMin(digest.size(), static_cast<size_t> (result.size())));
+
+  if(file_information.exists())
+    {
+      QMutexLocker locker(&s_digests_mutex);
+
+      if(s_digests.size() >= s_maximum_cached_digests)
+	s_digests.clear();
+
+      qup_cached_digest cached;
+
+      cached.m_digest = digest;
+      cached.m_modified = modified;
+      cached.m_size = size;
+      s_digests[absolute_file_name] = cached;
+    }
+
+  return digest;
+}
+
+void qup_files::categorize(const int slot)
+{
+  auto const flags = m_flags.at(slot);
+
+  for(auto &category : m_categories)
+    category.remove(slot);
+
+  if(flags & (qup_file::LocalMissing | qup_file::TemporaryMissing))
+    {
+      m_categories[static_cast<int> (Categories::Missing)] << slot;
+      return;
+    }
+
+  if(m_local_digests.at(slot) != m_temporary_digests.at(slot))
+    m_categories[static_cast<int> (Categories::Mismatched)] << slot;
+
+  if(m_local_permissions.at(slot) != m_temporary_permissions.at(slot))
+    m_categories[static_cast<int> (Categories::Permissions)] << slot;
+}
+
+void qup_files::clear(void)
+{
+  for(auto &category : m_categories)
+    category.clear();
+
+  m_directories.clear();
+  m_directory.clear();
+  m_directory_identifiers.clear();
+  m_flags.clear();
+  m_free.clear();
+  m_local_digests.clear();
+  m_local_permissions.clear();
+  m_names.clear();
+  m_slots.clear();
+  m_temporary_digests.clear();
+  m_temporary_permissions.clear();
+}
+
+void qup_files::remove(const int slot)
+{
+  if(!contains(slot))
+    return;
+
+  for(auto &category : m_categories)
+    category.remove(slot);
+
+  m_slots.remove(qMakePair(m_directory.at(slot), m_names.at(slot)));
+  m_directory[slot] = -1;
+  m_free << slot;
+  m_names[slot].clear();
+}
@@ -0,0 +1,131 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_files_h_
+#define _qup_files_h_
+
+#include <QHash>
+#include <QMetaType>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <array>
+
+typedef std::array<quint8, 32> qup_file_digest; // SHA3-256.
+
+class qup_file
+{
+ public:
+  enum Flags
+  {
+    LocalMissing = 1,
+    TemporaryMissing = 2
+  };
+
+  qup_file(void)
+  {
+    m_flags = 0;
+    m_local_digest.fill(0);
+    m_local_permissions = 0;
+    m_temporary_digest.fill(0);
+    m_temporary_permissions = 0;
+  }
+
+  QString m_relative_path;
+  qup_file_digest m_local_digest;
+  qup_file_digest m_temporary_digest;
+  quint16 m_local_permissions;
+  quint16 m_temporary_permissions;
+  quint8 m_flags;
+};
+
+Q_DECLARE_METATYPE(qup_file)
+
+/*
+** Gathered files are stored column-wise. Relative paths are separated
+** by '/' and lack a leading separator. Directories are interned,
+** digests are raw, and permissions are numeric. Text is prepared on demand.
+** Slots are stable; removed slots are recycled. Mismatched, missing, and
+** permission-differing slots are indexed as they are stored.
+*/
+
+class qup_files
+{
+ public:
+  enum class Categories
+  {
+    Mismatched = 0,
+    Missing = 1,
+    Permissions = 2,
+    XYZ = Permissions + 1
+  };
+
+  qup_files(void);
+  QSet<int> category(const Categories category) const;
+  QString local_digest(const int slot) const;
+  QString local_file_name(const int slot) const;
+  QString local_permissions(const int slot) const;
+  QString relative_path(const int slot) const;
+  QString temporary_digest(const int slot) const;
+  QString temporary_file_name(const int slot) const;
+  QString temporary_permissions(const int slot) const;
+  bool contains(const int slot) const;
+  bool in_category(const int slot, const Categories category) const;
+  bool mismatched(const int slot) const;
+  bool set_paths(const QString &destination_path, const QString &local_path);
+  int count(void) const;
+  int slot(const QString &relative_path) const;
+  int upsert(const qup_file &file, bool *changed);
+  qup_file file(const int slot) const;
+  static QString digest_as_string(const qup_file_digest &digest);
+  static qup_file_digest file_digest(const QString &file_name);
+  static QString permissions_as_string(const quint16 permissions);
+  void clear(void);
+  void remove(const int slot);
+
+ private:
+  QHash<QPair<int, QString>, int> m_slots;
+  QHash<QString, int> m_directory_identifiers;
+  QSet<int> m_categories[static_cast<int> (Categories::XYZ)];
+  QString m_destination_path;
+  QString m_local_path;
+  QVector<QString> m_directories;
+  QVector<QString> m_names;
+  QVector<int> m_directory;
+  QVector<int> m_free;
+  QVector<qup_file_digest> m_local_digests;
+  QVector<qup_file_digest> m_temporary_digests;
+  QVector<quint16> m_local_permissions;
+  QVector<quint16> m_temporary_permissions;
+  QVector<quint8> m_flags;
+  int intern(const QString &directory);
+  void categorize(const int slot);
+};
+
+#endif
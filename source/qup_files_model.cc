@@ -0,0 +1,735 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QBrush>
+#include <QFont>
+
+#include <algorithm>
+#include <numeric>
+
+#include "qup.h"
+#include "qup_files_model.h"
+
+const int static s_maximum_sorted_insertions = 64;
+
+qup_files_model::qup_files_model(QObject *parent):QAbstractTableModel(parent)
+{
+  m_filter = Filters::All;
+  m_sort_column = static_cast<int> (Columns::LocalFileName);
+  m_sort_order = Qt::AscendingOrder;
+  m_sorted = true;
+}
+
+qup_files_model::~qup_files_model()
+{
+}
+
+qup_files_model::Filters qup_files_model::filter(void) const
+{
+  return m_filter;
+}
+
+QString qup_files_model::text(const int slot, const int column) const
+{
+  switch(static_cast<Columns> (column))
+    {
+    case Columns::LocalFileDigest:
+      {
+	return m_files.local_digest(slot);
+      }
+    case Columns::LocalFileName:
+      {
+	return m_files.local_file_name(slot);
+      }
+    case Columns::LocalFilePermissions:
+      {
+	return m_files.local_permissions(slot);
+      }
+    case Columns::TemporaryFileDigest:
+      {
+	return m_files.temporary_digest(slot);
+      }
+    case Columns::TemporaryFileName:
+      {
+	return m_files.temporary_file_name(slot);
+      }
+    case Columns::TemporaryFilePermissions:
+      {
+	return m_files.temporary_permissions(slot);
+      }
+    default:
+      {
+	break;
+      }
+    }
+
+  return "";
+}
+
+QVector<int> qup_files_model::filtered(void) const
+{
+  /*
+  ** The categories are indexed by qup_files, so only the members of
+  ** the category are visited.
+  */
+
+  QSet<int> set;
+
+  switch(m_filter)
+    {
+    case Filters::Mismatched:
+      {
+	set = m_files.category(qup_files::Categories::Mismatched);
+	break;
+      }
+    case Filters::Missing:
+      {
+	set = m_files.category(qup_files::Categories::Missing);
+	break;
+      }
+    case Filters::Permissions:
+      {
+	set = m_files.category(qup_files::Categories::Permissions);
+	break;
+      }
+    default:
+      {
+	return QVector<int> ();
+      }
+    }
+
+  return ordered(QVector<int> (set.begin(), set.end()));
+}
+
+QVector<int> qup_files_model::ordered(const QVector<int> &members) const
+{
+  QVector<QPair<qup_file, int> > files;
+
+  files.reserve(members.size());
+
+  foreach(auto const slot, members)
+    files << qMakePair(m_files.file(slot), slot);
+
+  std::sort(files.begin(),
+	    files.end(),
+	    [&](const QPair<qup_file, int> &a, const QPair<qup_file, int> &b)
+	    {
+	      return less_than(a.first, b.first);
+	    });
+
+  QVector<int> vector;
+
+  vector.reserve(files.size());
+
+  for(int i = 0; i < files.size(); i++)
+    vector << files.at(i).second;
+
+  return vector;
+}
+
+bool qup_files_model::announce(void) const
+{
+  /*
+  ** Row signals describe m_order only if the view is not filtered.
+  */
+
+  return m_filter == Filters::All;
+}
+
+bool qup_files_model::less_than(const qup_file &f1, const qup_file &f2) const
+{
+  /*
+  ** Ties are resolved by the relative path so that the order is total.
+  */
+
+  auto const &a(m_sort_order == Qt::AscendingOrder ? f1 : f2);
+  auto const &b(m_sort_order == Qt::AscendingOrder ? f2 : f1);
+
+  switch(static_cast<Columns> (m_sort_column))
+    {
+    case Columns::LocalFileDigest:
+      {
+	if(a.m_local_digest != b.m_local_digest)
+	  return a.m_local_digest < b.m_local_digest;
+
+	break;
+      }
+    case Columns::LocalFilePermissions:
+      {
+	if(a.m_local_permissions != b.m_local_permissions)
+	  return a.m_local_permissions < b.m_local_permissions;
+
+	break;
+      }
+    case Columns::TemporaryFileDigest:
+      {
+	if(a.m_temporary_digest != b.m_temporary_digest)
+	  return a.m_temporary_digest < b.m_temporary_digest;
+
+	break;
+      }
+    case Columns::TemporaryFilePermissions:
+      {
+	if(a.m_temporary_permissions != b.m_temporary_permissions)
+	  return a.m_temporary_permissions < b.m_temporary_permissions;
+
+	break;
+      }
+    default:
+      {
+	return a.m_relative_path < b.m_relative_path;
+      }
+    }
+
+  return f1.m_relative_path < f2.m_relative_path;
+}
+
+int qup_files_model::position(const qup_file &file) const
+{
+  int high = m_order.size();
+  int low = 0;
+
+  while(low < high)
+    {
+      auto const middle = low + (high - low) / 2;
+
+      if(less_than(m_files.file(m_order.at(middle)), file))
+	low = middle + 1;
+      else
+	high = middle;
+    }
+
+  return low;
+}
+
+int qup_files_model::row(const int slot, const qup_file &file) const
+{
+  /*
+  ** The slot's storage may already hold newer values; file is the key
+  ** under which the row was sorted.
+  */
+
+  int high = m_order.size();
+  int low = 0;
+
+  while(low < high)
+    {
+      auto const middle = low + (high - low) / 2;
+
+      if(m_order.at(middle) == slot)
+	return middle;
+      else if(less_than(m_files.file(m_order.at(middle)), file))
+	low = middle + 1;
+      else
+	high = middle;
+    }
+
+  return -1;
+}
+
+QVariant qup_files_model::data(const QModelIndex &index, int role) const
+{
+  auto const &rows(announce() ? m_order : m_filtered);
+
+  if(!index.isValid() || index.row() < 0 || index.row() >= rows.size())
+    return QVariant();
+
+  auto const column = index.column();
+  auto const slot = rows.at(index.row());
+
+  switch(role)
+    {
+    case Qt::BackgroundRole:
+    case Qt::ForegroundRole:
+      {
+	if(column == static_cast<int> (Columns::LocalFilePermissions) ||
+	   column == static_cast<int> (Columns::TemporaryFilePermissions))
+	  {
+	    if(m_files.in_category(slot, qup_files::Categories::Permissions))
+	      return role == Qt::BackgroundRole ?
+		QBrush(qup::INVALID_PROCESS_COLOR) :
+		QBrush(qup::INVALID_PROCESS_COLOR.lighter());
+
+	    break;
+	  }
+
+	if(!(column == static_cast<int> (Columns::LocalFileDigest) ||
+	     column == static_cast<int> (Columns::TemporaryFileDigest)))
+	  break;
+
+	if(m_files.mismatched(slot))
+	  return role == Qt::BackgroundRole ?
+	    QBrush(qup::INVALID_PROCESS_COLOR) :
+	    QBrush(qup::INVALID_PROCESS_COLOR.lighter());
+
+	break;
+      }
+    case Qt::DisplayRole:
+      {
+	return text(slot, column);
+      }
+    case Qt::FontRole:
+      {
+	if(column == static_cast<int> (Columns::LocalFilePermissions) ||
+	   column == static_cast<int> (Columns::TemporaryFilePermissions))
+	  return QFont("Courier");
+
+	break;
+      }
+    case Qt::ToolTipRole:
+      {
+	QString tool_tip("<html>");
+
+	for(int i = 0; i < columnCount(); i++)
+	  {
+	    tool_tip.append
+	      (QString("<b>%1:</b> %2").
+	       arg(headerData(i, Qt::Horizontal, Qt::DisplayRole).toString()).
+	       arg(text(slot, i)));
+	    tool_tip.append(i < columnCount() - 1 ? "<br>" : "");
+	  }
+
+	tool_tip.append("</html>");
+	return tool_tip;
+      }
+    default:
+      {
+	break;
+      }
+    }
+
+  return QVariant();
+}
+
+QVariant qup_files_model::headerData
+(int section, Qt::Orientation orientation, int role) const
+{
+  if(orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    return QAbstractTableModel::headerData(section, orientation, role);
+
+  switch(static_cast<Columns> (section))
+    {
+    case Columns::LocalFileDigest:
+    case Columns::TemporaryFileDigest:
+      {
+	return tr("SHA3-256");
+      }
+    case Columns::LocalFileName:
+      {
+	return tr("Local File Name");
+      }
+    case Columns::LocalFilePermissions:
+    case Columns::TemporaryFilePermissions:
+      {
+	return tr("Permissions");
+      }
+    case Columns::TemporaryFileName:
+      {
+	return tr("Temporary Location File Name");
+      }
+    default:
+      {
+	break;
+      }
+    }
+
+  return QVariant();
+}
+
+int qup_files_model::columnCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int> (Columns::XYZ);
+}
+
+int qup_files_model::count(const Filters filter) const
+{
+  switch(filter)
+    {
+    case Filters::Mismatched:
+      {
+	return m_files.category(qup_files::Categories::Mismatched).size();
+      }
+    case Filters::Missing:
+      {
+	return m_files.category(qup_files::Categories::Missing).size();
+      }
+    case Filters::Permissions:
+      {
+	return m_files.category(qup_files::Categories::Permissions).size();
+      }
+    default:
+      {
+	return m_files.count();
+      }
+    }
+}
+
+int qup_files_model::rowCount(const QModelIndex &parent) const
+{
+  if(parent.isValid())
+    return 0;
+
+  return announce() ? m_order.size() : m_filtered.size();
+}
+
+int qup_files_model::seen(void) const
+{
+  return m_seen.size();
+}
+
+void qup_files_model::begin_merge(void)
+{
+  m_seen.clear();
+}
+
+void qup_files_model::clear(void)
+{
+  beginResetModel();
+  m_files.clear();
+  m_filtered.clear();
+  m_order.clear();
+  m_seen.clear();
+  m_sorted = true;
+  endResetModel();
+  emit counts_changed();
+}
+
+void qup_files_model::end_merge(const bool complete)
+{
+  auto changed = false;
+
+  if(complete)
+    {
+      /*
+      ** Remove the rows which were not gathered, one contiguous range
+      ** at a time.
+      */
+
+      for(int i = m_order.size() - 1; i >= 0; i--)
+	{
+	  if(m_seen.contains(m_order.at(i)))
+	    continue;
+
+	  auto j = i;
+
+	  while(j - 1 >= 0 && !m_seen.contains(m_order.at(j - 1)))
+	    j -= 1;
+
+	  announce() ? beginRemoveRows(QModelIndex(), j, i) : (void) 0;
+
+	  for(int k = j; k <= i; k++)
+	    m_files.remove(m_order.at(k));
+
+	  changed = true;
+	  m_order.remove(j, i - j + 1);
+	  announce() ? endRemoveRows() : (void) 0;
+	  i = j;
+	}
+    }
+
+  m_seen.clear();
+
+  if(changed)
+    refilter();
+
+  if(!m_sorted)
+    sort(m_sort_column, m_sort_order);
+
+  if(changed)
+    emit counts_changed();
+}
+
+void qup_files_model::merge(const QVector<qup_file> &data)
+{
+  /*
+  ** The batch is compared against the present snapshot by relative path.
+  ** Only inserted and changed rows are announced. Small insertions are
+  ** placed in sorted order. Large insertions, the initial population
+  ** for example, are appended and sorted once by end_merge().
+  */
+
+  QHash<int, int> rows;
+  QVector<int> inserted;
+  auto changed = false;
+
+  for(int i = 0; i < data.size(); i++)
+    {
+      auto const &file(data.at(i));
+      auto const previous_slot = m_files.slot(file.m_relative_path);
+      auto const previous(m_files.file(previous_slot));
+      auto c = false;
+      auto const slot = m_files.upsert(file, &c);
+
+      m_seen << slot;
+
+      if(previous_slot < 0)
+	{
+	  inserted << slot;
+	  continue;
+	}
+      else if(!c)
+	continue;
+
+      changed = true;
+
+      if(!m_sorted)
+	{
+	  if(!announce())
+	    continue;
+
+	  if(rows.isEmpty())
+	    for(int j = 0; j < m_order.size(); j++)
+	      rows[m_order.at(j)] = j;
+
+	  auto const r = rows.value(slot, -1);
+
+	  if(r >= 0)
+	    emit dataChanged(index(r, 0), index(r, columnCount() - 1));
+
+	  continue;
+	}
+
+      auto r = row(slot, previous);
+
+      if(r < 0)
+	continue;
+
+      if(less_than(previous, file) || less_than(file, previous))
+	{
+	  m_order.remove(r);
+
+	  auto const p = position(file);
+
+	  if(announce())
+	    {
+	      m_order.insert(r, slot);
+
+	      if(p != r &&
+		 beginMoveRows
+		 (QModelIndex(), r, r, QModelIndex(), p > r ? p + 1 : p))
+		{
+		  m_order.remove(r);
+		  m_order.insert(p, slot);
+		  endMoveRows();
+		  r = p;
+		}
+	    }
+	  else
+	    m_order.insert(p, slot);
+	}
+
+      if(announce())
+	emit dataChanged(index(r, 0), index(r, columnCount() - 1));
+    }
+
+  if(inserted.isEmpty())
+    {
+      if(changed)
+	{
+	  refilter();
+	  emit counts_changed();
+	}
+
+      return;
+    }
+
+  if(m_sorted && inserted.size() <= s_maximum_sorted_insertions)
+    for(int i = 0; i < inserted.size(); i++)
+      {
+	auto const p = position(m_files.file(inserted.at(i)));
+
+	announce() ? beginInsertRows(QModelIndex(), p, p) : (void) 0;
+	m_order.insert(p, inserted.at(i));
+	announce() ? endInsertRows() : (void) 0;
+      }
+  else
+    {
+      announce() ?
+	beginInsertRows(QModelIndex(),
+			m_order.size(),
+			m_order.size() + inserted.size() - 1) : (void) 0;
+      m_order << inserted;
+      m_sorted = false;
+      announce() ? endInsertRows() : (void) 0;
+    }
+
+  refilter();
+  emit counts_changed();
+}
+
+void qup_files_model::refilter(void)
+{
+  /*
+  ** The filtered rows are brought up to date with row removals and
+  ** insertions so that views retain their selections and positions.
+  ** Rows which are no longer in order are removed and inserted again.
+  */
+
+  if(announce())
+    return;
+
+  auto const target(filtered());
+  QHash<int, int> positions;
+  QVector<bool> kept(m_filtered.size(), false);
+  int last = -1;
+
+  for(int i = 0; i < target.size(); i++)
+    positions[target.at(i)] = i;
+
+  for(int i = 0; i < m_filtered.size(); i++)
+    {
+      auto const p = positions.value(m_filtered.at(i), -1);
+
+      if(p > last)
+	{
+	  kept[i] = true;
+	  last = p;
+	}
+    }
+
+  for(int i = m_filtered.size() - 1; i >= 0; i--)
+    {
+      if(kept.at(i))
+	continue;
+
+      auto j = i;
+
+      while(j - 1 >= 0 && !kept.at(j - 1))
+	j -= 1;
+
+      beginRemoveRows(QModelIndex(), j, i);
+      m_filtered.remove(j, i - j + 1);
+      endRemoveRows();
+      i = j;
+    }
+
+  /*
+  ** The remaining rows are a subsequence of the target. The missing
+  ** rows are inserted one contiguous range at a time.
+  */
+
+  for(int i = 0; i < target.size(); i++)
+    {
+      if(i < m_filtered.size() && m_filtered.at(i) == target.at(i))
+	continue;
+
+      auto const k = i < m_filtered.size() ?
+	positions.value(m_filtered.at(i)) : target.size();
+
+      beginInsertRows(QModelIndex(), i, k - 1);
+      m_filtered = m_filtered.mid(0, i) +
+	target.mid(i, k - i) +
+	m_filtered.mid(i);
+      endInsertRows();
+      i = k - 1;
+    }
+
+  if(!m_filtered.isEmpty())
+    emit dataChanged
+      (index(0, 0), index(m_filtered.size() - 1, columnCount() - 1));
+}
+
+void qup_files_model::set_filter(const Filters filter)
+{
+  if(filter == m_filter)
+    return;
+
+  beginResetModel();
+  m_filter = filter;
+  m_filtered = filtered();
+  endResetModel();
+}
+
+void qup_files_model::set_paths
+(const QString &destination_path, const QString &local_path)
+{
+  if(m_files.set_paths(destination_path, local_path) && rowCount() > 0)
+    emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
+}
+
+void qup_files_model::sort(int column, Qt::SortOrder order)
+{
+  if(column < 0 || column >= columnCount())
+    return;
+
+  m_sort_column = column;
+  m_sort_order = order;
+  m_sorted = true;
+  emit layoutAboutToBeChanged();
+
+  /*
+  ** Sort a permutation of the rows rather than the rows themselves.
+  */
+
+  QVector<int> permutation(m_order.size());
+  QVector<qup_file> files(m_order.size());
+
+  for(int i = 0; i < m_order.size(); i++)
+    files[i] = m_files.file(m_order.at(i));
+
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::sort(permutation.begin(),
+	    permutation.end(),
+	    [&](const int a, const int b)
+	    {
+	      return less_than(files.at(a), files.at(b));
+	    });
+
+  QVector<int> o(m_order.size());
+
+  for(int i = 0; i < permutation.size(); i++)
+    o[i] = m_order.at(permutation.at(i));
+
+  /*
+  ** The filtered rows are reordered. Their membership is changed by
+  ** refilter() only, outside of the layout change.
+  */
+
+  auto const previous(announce() ? m_order : m_filtered);
+
+  m_order = o;
+  m_filtered = ordered(m_filtered);
+
+  auto const &present(announce() ? m_order : m_filtered);
+  QHash<int, int> rows;
+
+  for(int i = 0; i < present.size(); i++)
+    rows[present.at(i)] = i;
+
+  auto const from(persistentIndexList());
+  QModelIndexList to;
+
+  for(int i = 0; i < from.size(); i++)
+    {
+      auto const r = rows.value(previous.value(from.at(i).row(), -1), -1);
+
+      to << (r >= 0 ? index(r, from.at(i).column()) : QModelIndex());
+    }
+
+  changePersistentIndexList(from, to);
+  emit layoutChanged();
+}
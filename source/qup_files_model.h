@@ -0,0 +1,100 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_files_model_h_
+#define _qup_files_model_h_
+
+#include <QAbstractTableModel>
+#include <QSet>
+
+#include "qup_files.h"
+
+class qup_files_model: public QAbstractTableModel
+{
+  Q_OBJECT
+
+ public:
+  enum class Columns
+  {
+    LocalFileDigest = 2,
+    LocalFileName = 0,
+    LocalFilePermissions = 1,
+    TemporaryFileDigest = 5,
+    TemporaryFileName = 3,
+    TemporaryFilePermissions = 4,
+    XYZ = TemporaryFileDigest + 1
+  };
+
+  enum class Filters
+  {
+    All = 0,
+    Mismatched = 1,
+    Missing = 2,
+    Permissions = 3
+  };
+
+  qup_files_model(QObject *parent);
+  ~qup_files_model();
+  Filters filter(void) const;
+  QVariant data(const QModelIndex &index, int role) const;
+  QVariant headerData
+    (int section, Qt::Orientation orientation, int role) const;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const;
+  int count(const Filters filter) const;
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  int seen(void) const;
+  void begin_merge(void);
+  void clear(void);
+  void end_merge(const bool complete);
+  void merge(const QVector<qup_file> &data);
+  void set_filter(const Filters filter);
+  void set_paths(const QString &destination_path, const QString &local_path);
+  void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+ private:
+  Filters m_filter;
+  Qt::SortOrder m_sort_order;
+  QSet<int> m_seen;
+  QVector<int> m_filtered; // Rows to slots of the filtered category.
+  QVector<int> m_order; // Rows to slots.
+  bool m_sorted;
+  int m_sort_column;
+  qup_files m_files;
+  QString text(const int slot, const int column) const;
+  QVector<int> filtered(void) const;
+  QVector<int> ordered(const QVector<int> &members) const;
+  bool announce(void) const;
+  bool less_than(const qup_file &f1, const qup_file &f2) const;
+  int position(const qup_file &file) const;
+  int row(const int slot, const qup_file &file) const;
+  void refilter(void);
+
+ signals:
+  void counts_changed(void);
+};
+
+#endif
@@ -0,0 +1,223 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include "qup_activity_model.h"
+#include "qup_batch.h"
+#include "qup_headless.h"
+#include "qup_journal.h"
+#include "qup_updater.h"
+
+const int static s_connections = 16;
+
+qup_headless::qup_headless(QObject *parent):QObject(parent)
+{
+  m_bandwidth = 0;
+  m_batch = nullptr;
+  m_connections = s_connections;
+  m_disk_workers = qMax(1, QThread::idealThreadCount());
+  m_journal = new qup_journal(this);
+}
+
+qup_headless::~qup_headless()
+{
+  delete m_batch;
+}
+
+bool qup_headless::parse(const QStringList &arguments)
+{
+  auto all = false;
+
+  for(int i = 1; i < arguments.size(); i++)
+    {
+      auto const argument(arguments.at(i));
+      auto const value(i + 1 < arguments.size() ? arguments.at(i + 1) : "");
+      auto ok = true;
+
+      if(argument == "--all")
+	all = true;
+      else if(argument == "--bandwidth" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_bandwidth = 1024LL * value.toLongLong(&ok);
+	  ok = ok && m_bandwidth >= 0;
+	}
+      else if(argument == "--connections" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_connections = value.toInt(&ok);
+	  ok = ok && m_connections > 0;
+	}
+      else if(argument == "--disk-workers" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_disk_workers = value.toInt(&ok);
+	  ok = ok && m_disk_workers > 0;
+	}
+      else if(argument == "--headless")
+	continue;
+      else if(argument == "--metrics-directory" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_metrics_directory = value;
+	}
+      else if(argument == "--update" && !value.isEmpty())
+	{
+	  i += 1;
+	  m_names.contains(value.trimmed()) ?
+	    (void) 0 : m_names.append(value.trimmed());
+	}
+      else
+	ok = false;
+
+      if(!ok)
+	return false;
+    }
+
+  auto const favorites(qup_updater::favorites());
+
+  if(all)
+    {
+      m_names = favorites;
+      return true;
+    }
+
+  if(m_names.isEmpty())
+    return false;
+
+  foreach(auto const &name, m_names)
+    if(!favorites.contains(name))
+      {
+	print("",
+	      tr("<font color='darkred'>Unknown favorite %1.</font>").
+	      arg(name));
+	return false;
+      }
+
+  return true;
+}
+
+bool qup_headless::requested(int argc, char *argv[])
+{
+  for(int i = 1; i < argc; i++)
+    if(qstrcmp(argv[i], "--all") == 0 ||
+       qstrcmp(argv[i], "--headless") == 0 ||
+       qstrcmp(argv[i], "--update") == 0)
+      return true;
+
+  return false;
+}
+
+int qup_headless::exec(void)
+{
+  if(!parse(QCoreApplication::arguments()))
+    {
+      print("",
+	    tr("Usage: qup [--headless] --all | --update <favorite> "
+	       "[--update <favorite> ...] [--bandwidth <KiB/s>] "
+	       "[--connections <count>] [--disk-workers <count>] "
+	       "[--metrics-directory <directory>]"));
+      return static_cast<int> (ExitCodes::Usage);
+    }
+
+  m_batch = new qup_batch(m_connections, m_disk_workers, m_bandwidth, this);
+  m_batch->set_metrics_directory(m_metrics_directory);
+  connect(m_batch,
+	  &qup_batch::append,
+	  this,
+	  &qup_headless::slot_append,
+	  Qt::DirectConnection);
+  connect(m_batch,
+	  &qup_batch::finished,
+	  this,
+	  &qup_headless::slot_finished);
+  QTimer::singleShot(0, this, [this](void)
+			      {
+				m_batch->start(m_names);
+			      });
+  return QCoreApplication::exec();
+}
+
+void qup_headless::print(const QString &name, const QString &text)
+{
+  /*
+  ** Thread-safe.
+  */
+
+  auto const plain_text(qup_activity_model::plain_text(text));
+
+  if(plain_text.isEmpty())
+    return;
+
+  if(!name.isEmpty())
+    m_journal->write
+      (name,
+       QDateTime::currentMSecsSinceEpoch(),
+       qup_activity_model::level(text),
+       plain_text);
+
+  QMutexLocker locker(&m_mutex);
+  QTextStream stream(stdout);
+
+  if(name.isEmpty())
+    stream << QString("[%1]: %2\n").
+      arg(QDateTime::currentDateTime().toString(Qt::ISODate)).
+      arg(plain_text);
+  else
+    stream << QString("[%1]: %2: %3\n").
+      arg(QDateTime::currentDateTime().toString(Qt::ISODate)).
+      arg(name).
+      arg(plain_text);
+
+  stream.flush();
+}
+
+void qup_headless::slot_append(const QString &name, const QString &text)
+{
+  print(name, text);
+}
+
+void qup_headless::slot_finished(const bool ok)
+{
+  QMutexLocker locker(&m_mutex);
+  QTextStream stream(stdout);
+
+  stream << "\n";
+
+  foreach(auto const &line, m_batch->summary())
+    stream << line << "\n";
+
+  stream.flush();
+  locker.unlock();
+  QCoreApplication::exit
+    (static_cast<int> (ok ? ExitCodes::Success : ExitCodes::Failure));
+}
@@ -0,0 +1,78 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_headless_h_
+#define _qup_headless_h_
+
+#include <QMutex>
+#include <QStringList>
+
+class qup_batch;
+class qup_journal;
+
+/*
+** Updates favorites without widgets. Activity is written to the
+** standard output and to the journals. The exit code is zero if every
+** update succeeded, one if the arguments are invalid, and two if
+** an update failed.
+*/
+
+class qup_headless: public QObject
+{
+  Q_OBJECT
+
+ public:
+  enum class ExitCodes
+  {
+    Failure = 2,
+    Success = 0,
+    Usage = 1
+  };
+
+  qup_headless(QObject *parent);
+  ~qup_headless();
+  static bool requested(int argc, char *argv[]);
+  int exec(void);
+
+ private:
+  QMutex m_mutex;
+  QString m_metrics_directory;
+  QStringList m_names;
+  int m_connections;
+  int m_disk_workers;
+  qint64 m_bandwidth; // Bytes per second.
+  qup_batch *m_batch;
+  qup_journal *m_journal;
+  bool parse(const QStringList &arguments);
+  void print(const QString &name, const QString &text);
+
+ private slots:
+  void slot_append(const QString &name, const QString &text);
+  void slot_finished(const bool ok);
+};
+
+#endif
@@ -0,0 +1,1092 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QMutex>
+#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "qup_files.h"
+#include "qup_installer.h"
+#include "qup_staging.h"
+#include "qup_trace.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+#ifndef RENAME_EXCHANGE
+#define RENAME_EXCHANGE (1 << 1)
+#endif
+#endif
+
+char const static *const s_shell_comment =
+  "# Here be special Qup instructions.";
+char const static *const s_temporary_suffix = ".qup_temporary";
+const int static s_maximum_workers = 8;
+
+qup_installer::qup_installer(const QString &destination_path,
+			     const QString &local_path,
+			     const QString &product)
+{
+  m_destination_path = QDir::cleanPath(destination_path);
+  m_disk_workers = nullptr;
+  m_durability = Durabilities::Batched;
+  m_keep_staged_files = true;
+  m_local_path = local_path;
+  m_mode = Modes::InPlace;
+  m_product = product;
+  m_target_path = m_destination_path;
+}
+
+qup_installer::~qup_installer()
+{
+}
+
+qup_installer::Durabilities qup_installer::string_as_durability
+(const QString &s)
+{
+  /*
+  ** Stable keys of the INI file. The English labels of earlier
+  ** versions are also accepted.
+  */
+
+  auto const string(s.trimmed().toLower());
+
+  if(string == "file" || string == "per file")
+    return Durabilities::File;
+  else if(string == "none")
+    return Durabilities::None;
+  else
+    return Durabilities::Batched;
+}
+
+qup_installer::Modes qup_installer::string_as_mode(const QString &s)
+{
+  return s.trimmed().toLower() == "swap" ? Modes::Swap : Modes::InPlace;
+}
+
+QString qup_installer::durability_as_string(const Durabilities durability)
+{
+  switch(durability)
+    {
+    case Durabilities::File:
+      {
+	return "file";
+      }
+    case Durabilities::None:
+      {
+	return "none";
+      }
+    default:
+      {
+	return "batched";
+      }
+    }
+}
+
+QString qup_installer::mode_as_string(const Modes mode)
+{
+  return mode == Modes::Swap ? "swap" : "in-place";
+}
+
+QString qup_installer::proper_path(const QString &path)
+{
+  return QFileInfo(path).absoluteFilePath();
+}
+
+QString qup_installer::sibling_path(const QString &suffix) const
+{
+  QFileInfo const file_information(m_destination_path);
+
+  return proper_path
+    (QString("%1%2.%3.qup-%4").
+     arg(file_information.absolutePath()).
+     arg(QDir::separator()).
+     arg(file_information.fileName()).
+     arg(suffix));
+}
+
+QString qup_installer::strategy_as_string(const Strategies strategy)
+{
+  switch(strategy)
+    {
+    case Strategies::CopyFileRange:
+      {
+	return tr("copy_file_range");
+      }
+    case Strategies::Reflink:
+      {
+	return tr("reflink");
+      }
+    case Strategies::Rename:
+      {
+	return tr("rename");
+      }
+    default:
+      {
+	return tr("buffered");
+      }
+    }
+}
+
+bool qup_installer::begin(void)
+{
+  m_statistics = Statistics();
+
+  if(m_mode == Modes::InPlace && !QFileInfo(m_destination_path).exists())
+    {
+      QString text("");
+
+      text.append(tr("<b>Creating %1... </b>").arg(m_destination_path));
+
+      if(QDir().mkpath(m_destination_path))
+	text.append(tr("<font color='darkgreen'>Created.</font>"));
+      else
+	{
+	  append(text + tr("<font color='darkred'>Failure.</font>"));
+	  return false;
+	}
+
+      append(text);
+    }
+  else if(m_mode == Modes::Swap)
+    {
+      m_target_path = sibling_path("next");
+      QDir(m_target_path).removeRecursively();
+
+      if(!QDir().mkpath(m_target_path))
+	{
+	  append(tr("<font color='darkred'>Cannot create %1.</font>").
+		 arg(m_target_path));
+	  return false;
+	}
+
+      link_tree();
+    }
+
+  return !canceled();
+}
+
+bool qup_installer::canceled(void) const
+{
+  return m_canceled ? m_canceled() : false;
+}
+
+bool qup_installer::commit(void)
+{
+  /*
+  ** Installed files are durable before the shell file, which is then
+  ** synchronized separately.
+  */
+
+  synchronize();
+  install_shell_file(m_statistics);
+  synchronize();
+
+  if(m_statistics.m_failed > 0)
+    append(tr("<font color='darkred'>%1 copied, %2 unchanged, %3 failed, "
+	      "%4 bytes written.</font>").
+	   arg(m_statistics.m_copied).
+	   arg(m_statistics.m_unchanged).
+	   arg(m_statistics.m_failed).
+	   arg(m_statistics.m_bytes));
+  else
+    append(tr("<b>%1 copied, %2 unchanged, %3 bytes written.</b>").
+	   arg(m_statistics.m_copied).
+	   arg(m_statistics.m_unchanged).
+	   arg(m_statistics.m_bytes));
+
+  if(m_mode == Modes::Swap && !swap())
+    {
+      QDir(m_target_path).removeRecursively();
+      return false;
+    }
+
+  return m_statistics.m_failed == 0;
+}
+
+bool qup_installer::copy_file(const QString &source,
+			      const QString &destination,
+			      const bool movable,
+			      Strategies &strategy) const
+{
+  /*
+  ** Strategies are attempted in order of decreasing economy: a rename
+  ** of an expendable source, a shared extent, an in-kernel copy, and
+  ** finally a buffered copy. Renames fail across file systems.
+  */
+
+  if(movable)
+    {
+#ifdef Q_OS_UNIX
+      if(::rename(QFile::encodeName(source).constData(),
+		  QFile::encodeName(destination).constData()) == 0)
+	{
+	  strategy = Strategies::Rename;
+	  return true;
+	}
+#else
+      if(QFile::rename(source, destination))
+	{
+	  strategy = Strategies::Rename;
+	  return true;
+	}
+#endif
+    }
+
+#ifdef Q_OS_LINUX
+  auto const in = ::open
+    (QFile::encodeName(source).constData(), O_CLOEXEC | O_RDONLY);
+
+  if(in >= 0)
+    {
+      struct stat st = {};
+
+      if(::fstat(in, &st) == 0)
+	{
+	  auto const out = ::open
+	    (QFile::encodeName(destination).constData(),
+	     O_CLOEXEC | O_CREAT | O_TRUNC | O_WRONLY,
+	     st.st_mode & 07777);
+
+	  if(out >= 0)
+	    {
+	      auto ok = ::ioctl(out, FICLONE, in) == 0;
+
+	      if(ok)
+		strategy = Strategies::Reflink;
+#ifdef SYS_copy_file_range
+	      else
+		{
+		  auto remaining = static_cast<qint64> (st.st_size);
+
+		  ok = true;
+
+		  while(remaining > 0)
+		    {
+		      auto const rc = ::syscall
+			(SYS_copy_file_range,
+			 in,
+			 nullptr,
+			 out,
+			 nullptr,
+			 static_cast<size_t> (remaining),
+			 0U);
+
+		      if(rc <= 0)
+			{
+			  ok = false;
+			  break;
+			}
+
+		      remaining -= rc;
+		    }
+
+		  if(ok)
+		    strategy = Strategies::CopyFileRange;
+		}
+#endif
+
+	      ::close(out);
+	      ::close(in);
+
+	      if(ok)
+		return true;
+	      else
+		QFile::remove(destination);
+	    }
+	  else
+	    ::close(in);
+	}
+      else
+	::close(in);
+    }
+#endif
+
+  strategy = Strategies::Buffered;
+  return QFile::copy(source, destination);
+}
+
+bool qup_installer::install(void)
+{
+  /*
+  ** Directories are created while the temporary directory is visited.
+  ** The files are then copied by a bounded pool of workers. Results
+  ** are reported in the order of the visit.
+  */
+
+  if(!begin())
+    return false;
+
+  QDirIterator it
+    (m_local_path,
+     QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
+     QDirIterator::Subdirectories);
+  QVector<QFileInfo> files;
+
+  while(it.hasNext() && !canceled())
+    {
+      it.next();
+
+      auto const file_information(it.fileInfo());
+
+      if(file_information.isDir())
+	create_directory(file_information.absoluteFilePath(), m_statistics);
+      else if(!file_information.fileName().endsWith(s_temporary_suffix) &&
+	      file_information.absoluteFilePath() !=
+	      qup_staging::marker(m_local_path))
+	files << file_information;
+    }
+
+  class Result
+  {
+  public:
+    Result(void)
+    {
+      m_done = false;
+    }
+
+    QStringList m_texts;
+    Statistics m_statistics;
+    bool m_done;
+  };
+
+  QMutex mutex;
+  QThreadPool pool;
+  QVector<Result> results(files.size());
+  QWaitCondition condition;
+
+  pool.setMaxThreadCount
+    (qBound(1, QThread::idealThreadCount(), s_maximum_workers));
+
+  for(int i = 0; i < files.size(); i++)
+    pool.start([&, i](void)
+	       {
+		 qup_trace::Span span("install", "Copy file");
+		 QStringList texts;
+		 Statistics statistics;
+
+		 if(!canceled())
+		   copy(files.at(i), texts, statistics);
+
+		 QMutexLocker locker(&mutex);
+
+		 results[i].m_done = true;
+		 results[i].m_statistics = statistics;
+		 results[i].m_texts = texts;
+		 condition.wakeAll();
+	       });
+
+  for(int i = 0; i < files.size(); i++)
+    {
+      QStringList texts;
+
+      {
+	QMutexLocker locker(&mutex);
+
+	while(!results.at(i).m_done)
+	  condition.wait(&mutex);
+
+	m_statistics.m_bytes += results.at(i).m_statistics.m_bytes;
+	m_statistics.m_copied += results.at(i).m_statistics.m_copied;
+	m_statistics.m_failed += results.at(i).m_statistics.m_failed;
+	m_statistics.m_unchanged += results.at(i).m_statistics.m_unchanged;
+	texts.swap(results[i].m_texts);
+      }
+
+      foreach(auto const &text, texts)
+	append(text);
+    }
+
+  pool.waitForDone();
+
+  if(canceled())
+    {
+      discard();
+      return false;
+    }
+
+  return commit();
+}
+
+bool qup_installer::link(const QString &existing, const QString &path)
+{
+#ifdef Q_OS_UNIX
+  return ::link(QFile::encodeName(existing).constData(),
+		QFile::encodeName(path).constData()) == 0;
+#else
+  Q_UNUSED(existing);
+  Q_UNUSED(path);
+  return false;
+#endif
+}
+
+bool qup_installer::prepare_shell_file(const QString &path) const
+{
+  QFileInfo const file_information(path);
+  auto const file_name(file_information.fileName().toLower());
+
+  if(!(file_name == m_product.toLower() + ".bash" ||
+       file_name == m_product.toLower() + ".sh"))
+    return false;
+
+  QFile file(path);
+  QFile temporary(path + s_temporary_suffix);
+
+  if(file.open(QIODevice::ReadOnly | QIODevice::Text) &&
+     temporary.open(QIODevice::Text |
+		    QIODevice::Truncate |
+		    QIODevice::WriteOnly))
+    {
+      QByteArray data(4096, '0');
+      qint64 rc = 0;
+
+      while((rc = file.readLine(data.data(),
+				static_cast<qint64> (data.length()))) > 0)
+	{
+	  temporary.write(data.mid(0, static_cast<int> (rc)));
+
+	  if(data.mid(0, static_cast<int> (rc)).trimmed() == s_shell_comment)
+	    {
+	      QString text("");
+
+	      if(path.toLower().trimmed().endsWith(".sh"))
+		{
+		  text.append("\n");
+		  text.append
+		    (QString("if [ -r %1/%2 ] && [ -x %1/%2 ]\n").
+		     arg(proper_path(m_destination_path)).arg(m_product));
+		  text.append("then\n");
+		  text.append
+		    (QString("    echo \"Launching an official %1.\"\n").
+		     arg(m_product));
+		  text.append
+		    (QString("    cd %1 && exec ./%2 \"$qup_arguments\" "
+			     "\"$@\"\n").
+		     arg(proper_path(m_destination_path)).arg(m_product));
+		  text.append("    exit $?\n");
+		  text.append("fi\n\n");
+		}
+
+	      if(text.length() > 0)
+		temporary.write(text.toUtf8());
+	    }
+	}
+    }
+
+  file.close();
+  temporary.close();
+
+  /*
+  ** The prepared shell file replaces the staged one in install_shell_file().
+  */
+
+  return QFileInfo(path).dir() == QDir(m_local_path) &&
+    QFileInfo::exists(path + s_temporary_suffix);
+}
+
+bool qup_installer::swap(void)
+{
+  /*
+  ** The prepared tree is exchanged with the destination in one step.
+  ** A destination which is a symbolic link is redirected instead.
+  */
+
+  QFileInfo const destination(m_destination_path);
+  auto const previous(sibling_path("previous"));
+  auto const text
+    (tr("Exchanging %1 and %2... ").
+     arg(m_target_path).arg(m_destination_path));
+  auto ok = false;
+
+#ifdef Q_OS_UNIX
+  if(destination.isSymLink())
+    {
+      auto const link_path(sibling_path("link"));
+      auto const prior_tree(destination.symLinkTarget());
+      auto const tree
+	(sibling_path(QString::number(QDateTime::currentMSecsSinceEpoch())));
+
+      QFile::remove(link_path);
+
+      if(QDir().rename(m_target_path, tree) &&
+	 QFile::link(tree, link_path) &&
+	 ::rename(QFile::encodeName(link_path).constData(),
+		  QFile::encodeName(m_destination_path).constData()) == 0)
+	{
+	  QDir const directory(destination.absolutePath());
+	  auto const prefix(QString(".%1.qup-").arg(destination.fileName()));
+
+	  foreach(auto const &entry,
+		  directory.entryInfoList(QStringList() << prefix + "*",
+					  QDir::Dirs |
+					  QDir::Hidden |
+					  QDir::NoDotAndDotDot))
+	    {
+	      auto numeric = false;
+
+	      entry.fileName().mid(prefix.length()).toLongLong(&numeric);
+
+	      if(numeric &&
+		 entry.absoluteFilePath() != proper_path(prior_tree) &&
+		 entry.absoluteFilePath() != proper_path(tree))
+		QDir(entry.absoluteFilePath()).removeRecursively();
+	    }
+
+	  append(text +
+		 tr("<font color='darkgreen'>Exchanged. The previous tree "
+		    "is %1.</font>").arg(prior_tree));
+	  sync(destination.absolutePath());
+	  return true;
+	}
+
+      QDir(tree).removeRecursively();
+      QFile::remove(link_path);
+      append(text + tr("<font color='darkred'>Failure.</font>"));
+      return false;
+    }
+#endif
+
+  if(!destination.exists())
+    ok = QDir().rename(m_target_path, m_destination_path);
+  else
+    {
+#if defined(Q_OS_LINUX) && defined(SYS_renameat2)
+      if(syscall(SYS_renameat2,
+		 AT_FDCWD,
+		 QFile::encodeName(m_target_path).constData(),
+		 AT_FDCWD,
+		 QFile::encodeName(m_destination_path).constData(),
+		 RENAME_EXCHANGE) == 0)
+	{
+	  QDir(previous).removeRecursively();
+	  QDir().rename(m_target_path, previous);
+	  ok = true;
+	}
+#endif
+
+      if(!ok)
+	{
+	  /*
+	  ** The exchange is not supported. Two renames follow.
+	  */
+
+	  QDir(previous).removeRecursively();
+
+	  if(QDir().rename(m_destination_path, previous))
+	    {
+	      ok = QDir().rename(m_target_path, m_destination_path);
+	      ok ? (void) 0 : (void) QDir().rename(previous, m_destination_path);
+	    }
+	}
+    }
+
+  if(ok)
+    {
+      append(text +
+	     tr("<font color='darkgreen'>Exchanged. The previous tree "
+		"is %1.</font>").arg(previous));
+      sync(destination.absolutePath());
+    }
+  else
+    append(text + tr("<font color='darkred'>Failure.</font>"));
+
+  return ok;
+}
+
+void qup_installer::append(const QString &text) const
+{
+  if(m_append)
+    m_append(text);
+}
+
+
+void qup_installer::copy(const QFileInfo &file_information,
+			 QStringList &texts,
+			 Statistics &statistics) const
+{
+  /*
+  ** Disk workers may be shared by several installers.
+  */
+
+  if(m_disk_workers)
+    m_disk_workers->acquire();
+
+  QSemaphoreReleaser releaser(m_disk_workers);
+
+  if(prepare_shell_file(file_information.absoluteFilePath()))
+    return;
+
+  /*
+  ** Desktop files are installed first since the staged file may be
+  ** moved into the destination.
+  */
+
+  if(file_information.suffix() == "desktop")
+    {
+      auto destination
+	(QStandardPaths::writableLocation(QStandardPaths::DesktopLocation));
+
+      if(destination.isEmpty() == false)
+	{
+	  QDir().mkpath(destination);
+	  destination.append(QDir::separator());
+	  destination.append(file_information.fileName());
+	  destination = proper_path(destination);
+	  install_file(file_information.absoluteFilePath(),
+		       destination,
+		       file_information.permissions(),
+		       false,
+		       texts,
+		       statistics);
+	}
+      else
+	texts << tr("<font color='darkred'>A Desktop location is "
+		    "not defined.</font>");
+    }
+
+  QString destination("");
+
+  destination.append(m_target_path);
+  destination.append(QDir::separator());
+  destination.append
+    (file_information.absoluteFilePath().remove(m_local_path));
+  destination = proper_path(destination);
+  install_file(file_information.absoluteFilePath(),
+	       destination,
+	       file_information.permissions(),
+	       !m_keep_staged_files,
+	       texts,
+	       statistics);
+}
+
+void qup_installer::create_directory
+(const QString &path, Statistics &statistics) const
+{
+  auto destination(m_target_path);
+
+  destination.append(QDir::separator());
+  destination.append(QString(path).remove(m_local_path));
+  destination = proper_path(destination);
+
+  if(!QFileInfo(destination).exists())
+    {
+      QString text("");
+
+      text.append(tr("Creating %1... ").arg(destination));
+
+      if(QDir().mkpath(destination))
+	text.append(tr("<font color='darkgreen'>Created.</font>"));
+      else
+	{
+	  statistics.m_failed += 1;
+	  text.append(tr("<font color='darkred'>Failure.</font>"));
+	}
+
+      append(text);
+    }
+}
+
+void qup_installer::discard(void)
+{
+  /*
+  ** Installed files remain in place. A prepared tree is removed.
+  */
+
+  {
+    QMutexLocker locker(&m_unsynchronized_mutex);
+
+    m_unsynchronized.clear();
+    m_unsynchronized_directories.clear();
+  }
+
+  if(m_mode == Modes::Swap)
+    {
+      QDir(m_target_path).removeRecursively();
+      append(tr("<font color='darkred'>The installation was abandoned. "
+		"%1 is unchanged.</font>").arg(m_destination_path));
+    }
+}
+
+void qup_installer::install(const QString &path)
+{
+  /*
+  ** A single staged file, perhaps just downloaded. Its directories
+  ** are created as necessary.
+  */
+
+  QFileInfo const file_information(path);
+
+  if(canceled() ||
+     !file_information.isFile() ||
+     !file_information.absoluteFilePath().startsWith(m_local_path))
+    return;
+
+  create_directory(file_information.absolutePath(), m_statistics);
+
+  QStringList texts;
+
+  copy(file_information, texts, m_statistics);
+
+  foreach(auto const &text, texts)
+    append(text);
+}
+
+void qup_installer::install_file(const QString &source,
+				 const QString &destination,
+				 const QFileDevice::Permissions permissions,
+				 const bool movable,
+				 QStringList &texts,
+				 Statistics &statistics) const
+{
+  /*
+  ** Installed files receive the modification times of their sources.
+  ** Identical sizes and times imply identical files. Otherwise, the
+  ** cached digests are compared. Linked files are shared with the
+  ** installed tree and their permissions are not altered.
+  */
+
+  QFileInfo const destination_information(destination);
+  QFileInfo const source_information(source);
+  auto const modified(source_information.lastModified());
+  auto const size = source_information.size();
+
+  if(destination_information.isFile() &&
+     (m_mode == Modes::InPlace ||
+      destination_information.permissions() == permissions) &&
+     destination_information.size() == size &&
+     (destination_information.lastModified() == modified ||
+      qup_files::file_digest(destination) == qup_files::file_digest(source)))
+    {
+      QFile file(destination);
+
+      if(destination_information.lastModified() != modified &&
+	 file.open(QIODevice::ReadOnly))
+	{
+	  file.setFileTime(modified, QFileDevice::FileModificationTime);
+	  file.close();
+	}
+
+      if(destination_information.permissions() != permissions)
+	{
+	  QString text("");
+
+	  text.append(tr("Setting permissions on %1... ").arg(destination));
+
+	  if(file.setPermissions(permissions))
+	    text.append(tr("<font color='darkgreen'>Success.</font>"));
+	  else
+	    {
+	      statistics.m_failed += 1;
+	      text.append(tr("<font color='darkred'>Failure.</font>"));
+	    }
+
+	  texts << text;
+	}
+
+      statistics.m_unchanged += 1;
+      return;
+    }
+
+  if(destination_information.exists())
+    QFile::remove(destination);
+
+  QString text("");
+  auto strategy = Strategies::Buffered;
+
+  text.append(tr("Copying %1 to %2... ").arg(source).arg(destination));
+
+  if(copy_file(source, destination, movable, strategy))
+    {
+      /*
+      ** Shared extents and renames do not write data.
+      */
+
+      statistics.m_bytes +=
+	strategy == Strategies::Buffered ||
+	strategy == Strategies::CopyFileRange ? size : 0;
+      statistics.m_copied += 1;
+      text.append(tr("<font color='darkgreen'>Copied (%1).</font>").
+		  arg(strategy_as_string(strategy)));
+      texts << text;
+      text.clear();
+      text.append(tr("Setting permissions on %1... ").arg(destination));
+
+      QFile file(destination);
+
+      if(file.open(QIODevice::ReadOnly))
+	{
+	  file.setFileTime(modified, QFileDevice::FileModificationTime);
+	  file.close();
+	}
+
+      if(file.setPermissions(permissions))
+	text.append(tr("<font color='darkgreen'>Success.</font>"));
+      else
+	{
+	  statistics.m_failed += 1;
+	  text.append(tr("<font color='darkred'>Failure.</font>"));
+	}
+
+      texts << text;
+
+      if(m_durability == Durabilities::File)
+	sync(destination);
+
+      if(m_durability != Durabilities::None)
+	{
+	  /*
+	  ** Renamed entries are durable once their directories are
+	  ** synchronized.
+	  */
+
+	  QMutexLocker locker(&m_unsynchronized_mutex);
+
+	  if(m_durability == Durabilities::Batched)
+	    m_unsynchronized << destination;
+
+	  m_unsynchronized_directories <<
+	    QFileInfo(destination).absolutePath();
+	}
+    }
+  else
+    {
+      statistics.m_failed += 1;
+      text.append(tr("<font color='darkred'>Failure.</font>"));
+      texts << text;
+    }
+}
+
+void qup_installer::install_shell_file(Statistics &statistics) const
+{
+  foreach(auto const &string, QStringList() << ".bash" << ".sh")
+    {
+      auto const shell_file_name
+	(QString("%1%2%3%4").
+	 arg(m_target_path).
+	 arg(QDir::separator()).
+	 arg(m_product.toLower()).
+	 arg(string));
+      auto const staged_shell_file_name
+	(QString("%1%2%3%4").
+	 arg(m_local_path).
+	 arg(QDir::separator()).
+	 arg(m_product.toLower()).
+	 arg(string));
+      auto const temporary_shell_file_name
+	(staged_shell_file_name + s_temporary_suffix);
+
+      if(QFileInfo::exists(temporary_shell_file_name))
+	{
+	  QStringList texts;
+
+	  install_file
+	    (temporary_shell_file_name,
+	     proper_path(shell_file_name),
+	     QFileDevice::ExeOwner |
+	     QFileInfo(staged_shell_file_name).permissions(),
+	     true,
+	     texts,
+	     statistics);
+	  QFile::remove(temporary_shell_file_name);
+
+	  foreach(auto const &text, texts)
+	    append(text);
+
+	  break;
+	}
+    }
+}
+
+void qup_installer::link_tree(void)
+{
+  /*
+  ** The installed tree is reproduced with links so that files which
+  ** are not staged survive the exchange.
+  */
+
+  if(!QFileInfo(m_destination_path).isDir())
+    return;
+
+  QDirIterator it
+    (m_destination_path,
+     QDir::Dirs | QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot,
+     QDirIterator::Subdirectories);
+  quint64 copied = 0;
+  quint64 linked = 0;
+
+  while(it.hasNext() && !canceled())
+    {
+      it.next();
+
+      auto const file_information(it.fileInfo());
+      auto const path
+	(proper_path(m_target_path +
+		     QDir::separator() +
+		     file_information.absoluteFilePath().
+		     remove(m_destination_path)));
+
+      if(file_information.isSymLink())
+	QFile::link(file_information.symLinkTarget(), path);
+      else if(file_information.isDir())
+	QDir().mkpath(path);
+      else if(link(file_information.absoluteFilePath(), path))
+	linked += 1;
+      else if(QFile::copy(file_information.absoluteFilePath(), path))
+	copied += 1;
+    }
+
+  append(tr("Prepared %1 with %2 linked and %3 copied files.").
+	 arg(m_target_path).arg(linked).arg(copied));
+}
+
+void qup_installer::set_append
+(const std::function<void (const QString &)> &append)
+{
+  m_append = append;
+}
+
+void qup_installer::set_canceled(const std::function<bool (void)> &canceled)
+{
+  m_canceled = canceled;
+}
+
+void qup_installer::set_disk_workers(QSemaphore *disk_workers)
+{
+  m_disk_workers = disk_workers;
+}
+
+void qup_installer::set_durability(const Durabilities durability)
+{
+  m_durability = durability;
+}
+
+void qup_installer::set_keep_staged_files(const bool state)
+{
+  m_keep_staged_files = state;
+}
+
+void qup_installer::set_mode(const Modes mode)
+{
+  m_mode = mode;
+}
+
+void qup_installer::sync(const QString &path)
+{
+#ifdef Q_OS_UNIX
+  auto const fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+
+  if(fd >= 0)
+    {
+#ifdef Q_OS_LINUX
+      ::fdatasync(fd);
+#else
+      ::fsync(fd);
+#endif
+      ::close(fd);
+    }
+#else
+  Q_UNUSED(path);
+#endif
+}
+
+void qup_installer::synchronize(void)
+{
+  /*
+  ** Batched durability. One syncfs() covers the target's file system.
+  ** Otherwise, the installed files are synchronized as a group. Per File
+  ** durability synchronizes the parent directories of the installed files.
+  */
+
+  QSet<QString> directories;
+  QStringList paths;
+
+  {
+    QMutexLocker locker(&m_unsynchronized_mutex);
+
+    directories.swap(m_unsynchronized_directories);
+    paths.swap(m_unsynchronized);
+  }
+
+  if(m_durability == Durabilities::File)
+    {
+      foreach(auto const &directory, directories)
+	sync(directory);
+
+      if(!directories.isEmpty())
+	append(tr("Synchronized %1 directory(ies).").arg(directories.size()));
+
+      return;
+    }
+
+  if(paths.isEmpty())
+    return;
+
+#ifdef Q_OS_LINUX
+  auto const fd = ::open
+    (QFile::encodeName(m_target_path).constData(), O_CLOEXEC | O_RDONLY);
+
+  if(fd >= 0)
+    {
+      auto const rc = ::syncfs(fd);
+
+      ::close(fd);
+
+      if(rc == 0)
+	{
+	  append(tr("Synchronized the file system of %1.").
+		 arg(m_target_path));
+	  return;
+	}
+    }
+#endif
+
+  foreach(auto const &path, paths)
+    sync(path);
+
+  foreach(auto const &directory, directories)
+    sync(directory);
+
+  append(tr("Synchronized %1 file(s).").arg(paths.size()));
+}
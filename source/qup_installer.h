@@ -0,0 +1,161 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_installer_h_
+#define _qup_installer_h_
+
+#include <QCoreApplication>
+#include <QFileDevice>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSemaphore>
+#include <QSet>
+#include <QStringList>
+
+#include <functional>
+
+/*
+** In Place: changed files are replaced within the destination.
+** Swap: a complete tree is prepared beside the destination, unchanged
+** files are linked, and the trees are exchanged. The previous tree is
+** retained beside the destination.
+**
+** Durability: installed files are synchronized individually, together
+** before the shell file is installed, or not at all.
+**
+** install() visits the temporary directory. Alternatively, begin(),
+** install(path) for each staged file, and commit() or discard(). A
+** session is used by one thread at a time.
+*/
+
+class qup_installer
+{
+  Q_DECLARE_TR_FUNCTIONS(qup_installer)
+
+ public:
+  enum class Durabilities
+  {
+    Batched = 0,
+    File,
+    None
+  };
+
+  enum class Modes
+  {
+    InPlace = 0,
+    Swap
+  };
+
+  qup_installer(const QString &destination_path,
+		const QString &local_path,
+		const QString &product);
+  ~qup_installer();
+  static Durabilities string_as_durability(const QString &s);
+  static Modes string_as_mode(const QString &s);
+  static QString durability_as_string(const Durabilities durability);
+  static QString mode_as_string(const Modes mode);
+  static QString proper_path(const QString &path);
+  bool begin(void);
+  bool commit(void);
+  bool install(void);
+  void discard(void);
+  void install(const QString &path);
+  void set_append(const std::function<void (const QString &)> &append);
+  void set_canceled(const std::function<bool (void)> &canceled);
+  void set_disk_workers(QSemaphore *disk_workers);
+  void set_durability(const Durabilities durability);
+  void set_keep_staged_files(const bool state);
+  void set_mode(const Modes mode);
+
+ private:
+  enum class Strategies
+  {
+    Buffered = 0,
+    CopyFileRange,
+    Reflink,
+    Rename
+  };
+
+  class Statistics
+  {
+  public:
+    Statistics(void)
+    {
+      m_bytes = 0;
+      m_copied = 0;
+      m_failed = 0;
+      m_unchanged = 0;
+    }
+
+    qint64 m_bytes;
+    quint64 m_copied;
+    quint64 m_failed;
+    quint64 m_unchanged;
+  };
+
+  Durabilities m_durability;
+  Modes m_mode;
+  QSet<QString> mutable m_unsynchronized_directories;
+  QString m_destination_path;
+  QString m_local_path;
+  QString m_product;
+  QString m_target_path;
+  QStringList mutable m_unsynchronized;
+  QMutex mutable m_unsynchronized_mutex;
+  QSemaphore *m_disk_workers;
+  Statistics m_statistics;
+  bool m_keep_staged_files;
+  std::function<bool (void)> m_canceled;
+  std::function<void (const QString &)> m_append;
+  QString sibling_path(const QString &suffix) const;
+  bool canceled(void) const;
+  bool copy_file(const QString &source,
+		 const QString &destination,
+		 const bool movable,
+		 Strategies &strategy) const;
+  bool prepare_shell_file(const QString &path) const;
+  bool swap(void);
+  static QString strategy_as_string(const Strategies strategy);
+  static bool link(const QString &existing, const QString &path);
+  static void sync(const QString &path);
+  void synchronize(void);
+  void append(const QString &text) const;
+  void copy(const QFileInfo &file_information,
+	    QStringList &texts,
+	    Statistics &statistics) const;
+  void create_directory(const QString &path, Statistics &statistics) const;
+  void install_file(const QString &source,
+		    const QString &destination,
+		    const QFileDevice::Permissions permissions,
+		    const bool movable,
+		    QStringList &texts,
+		    Statistics &statistics) const;
+  void install_shell_file(Statistics &statistics) const;
+  void link_tree(void);
+};
+
+#endif
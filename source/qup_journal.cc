@@ -0,0 +1,187 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+
+#include "qup.h"
+#include "qup_journal.h"
+
+const int static s_flush_interval = 1000; // Milliseconds.
+const int static s_maximum_pending_lines = 512;
+const int static s_maximum_rotations = 5;
+const qint64 static s_maximum_size = 4 * 1024 * 1024;
+
+qup_journal::qup_journal(QObject *parent):QThread(parent)
+{
+  m_stop = false;
+  start(QThread::LowPriority);
+}
+
+qup_journal::~qup_journal()
+{
+  {
+    QMutexLocker locker(&m_mutex);
+
+    m_stop = true;
+    m_condition.wakeOne();
+  }
+
+  wait();
+}
+
+QString qup_journal::directory(void)
+{
+  return qup::home_path() + QDir::separator() + "journals";
+}
+
+QString qup_journal::file_name(const QString &name)
+{
+  QString string("");
+
+  for(int i = 0; i < name.trimmed().size(); i++)
+    {
+      auto const c(name.trimmed().at(i));
+
+      if(c.isLetterOrNumber() || c == '-' || c == '.' || c == '_')
+	string.append(c);
+      else
+	string.append('_');
+    }
+
+  if(string.isEmpty())
+    return "";
+
+  return directory() + QDir::separator() + string + ".journal";
+}
+
+void qup_journal::enqueue(const QString &file_name,
+			  const qint64 time,
+			  const Levels level,
+			  const QString &text)
+{
+  if(file_name.isEmpty())
+    return;
+
+  Line line;
+  auto t(text);
+
+  t.replace('\\', "\\\\");
+  t.replace('\n', "\\n");
+  t.replace('\t', "\\t");
+  line.m_line.append(QByteArray::number(time));
+  line.m_line.append('\t');
+  line.m_line.append(static_cast<char> (level));
+  line.m_line.append('\t');
+  line.m_line.append(t.toUtf8());
+  line.m_line.append('\n');
+  line.m_file_name = file_name;
+
+  QMutexLocker locker(&m_mutex);
+
+  m_lines << line;
+
+  if(m_lines.size() >= s_maximum_pending_lines)
+    m_condition.wakeOne();
+}
+
+void qup_journal::flush(const QVector<Line> &lines)
+{
+  /*
+  ** Concurrent updates interleave their lines. Each journal is opened
+  ** once per flush.
+  */
+
+  QMap<QString, QByteArray> contents;
+
+  for(int i = 0; i < lines.size(); i++)
+    contents[lines.at(i).m_file_name].append(lines.at(i).m_line);
+
+  QMapIterator<QString, QByteArray> it(contents);
+
+  while(it.hasNext())
+    {
+      it.next();
+      QDir().mkpath(directory());
+      rotate(it.key());
+
+      QFile file(it.key());
+
+      if(file.open(QIODevice::Append | QIODevice::WriteOnly))
+	file.write(it.value());
+    }
+}
+
+void qup_journal::rotate(const QString &file_name)
+{
+  if(QFileInfo(file_name).size() < s_maximum_size)
+    return;
+
+  QFile::remove(QString("%1.%2").arg(file_name).arg(s_maximum_rotations));
+
+  for(int i = s_maximum_rotations - 1; i >= 1; i--)
+    QFile::rename(QString("%1.%2").arg(file_name).arg(i),
+		  QString("%1.%2").arg(file_name).arg(i + 1));
+
+  QFile::rename(file_name, QString("%1.1").arg(file_name));
+}
+
+void qup_journal::run(void)
+{
+  forever
+    {
+      QVector<Line> lines;
+
+      {
+	QMutexLocker locker(&m_mutex);
+
+	if(!m_stop && m_lines.size() < s_maximum_pending_lines)
+	  m_condition.wait(&m_mutex, s_flush_interval);
+
+	lines.swap(m_lines);
+
+	if(lines.isEmpty() && m_stop)
+	  break;
+      }
+
+      flush(lines);
+    }
+}
+
+void qup_journal::write(const QString &name,
+			const qint64 time,
+			const Levels level,
+			const QString &text)
+{
+  /*
+  ** May be issued by any thread.
+  */
+
+  enqueue(file_name(name), time, level, text);
+}
@@ -0,0 +1,87 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_journal_h_
+#define _qup_journal_h_
+
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+/*
+** Journals are recorded in qup::home_path()/journals, one per product.
+** Each line is composed of tab-separated fields:
+** milliseconds since the epoch, a level (E, I, S), and the text.
+** Tabs, new lines, and backslashes in the text are escaped. A process
+** shares one instance so that a single thread appends to and rotates
+** the journals.
+*/
+
+class qup_journal: public QThread
+{
+  Q_OBJECT
+
+ public:
+  enum class Levels
+  {
+    Failure = 'E',
+    Information = 'I',
+    Success = 'S'
+  };
+
+  qup_journal(QObject *parent);
+  ~qup_journal();
+  static QString directory(void);
+  static QString file_name(const QString &name);
+  void write(const QString &name,
+	     const qint64 time,
+	     const Levels level,
+	     const QString &text);
+
+ private:
+  class Line
+  {
+  public:
+    QByteArray m_line;
+    QString m_file_name;
+  };
+
+  QMutex m_mutex;
+  QVector<Line> m_lines;
+  QWaitCondition m_condition;
+  bool m_stop;
+  static void flush(const QVector<Line> &lines);
+  static void rotate(const QString &file_name);
+  void enqueue(const QString &file_name,
+	       const qint64 time,
+	       const Levels level,
+	       const QString &text);
+  void run(void);
+};
+
+#endif
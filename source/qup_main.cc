@@ -36,6 +36,10 @@
 #endif
 
 #include "qup.h"
+#include "qup_benchmark.h"
+#include "qup_files.h"
+#include "qup_headless.h"
+#include "qup_trace.h"
 
 int main(int argc, char *argv[])
 {
@@ -45,7 +49,36 @@ int main(int argc, char *argv[])
   QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps, true);
 #endif
 #endif
-  qRegisterMetaType<QVector<QVector<QString> > > ("QVectorQVectorQString");
+  qup_trace::initialize();
+  qup::trace_startup("Process started");
+  qRegisterMetaType<QVector<qup_file> > ("QVectorqup_file");
+
+  if(qup_benchmark::requested(argc, argv) ||
+     qup_headless::requested(argc, argv))
+    {
+      QCoreApplication qcoreapplication(argc, argv);
+      QDir dir;
+
+      dir.mkdir(qup::home_path());
+      QCoreApplication::setApplicationName("Qup");
+      QCoreApplication::setApplicationVersion(qup::VERSION);
+      QCoreApplication::setOrganizationName("Qup");
+      QSettings::setDefaultFormat(QSettings::IniFormat);
+      QSettings::setPath
+	(QSettings::IniFormat, QSettings::UserScope, qup::home_path());
+      qup::set_proxy();
+
+      if(qup_benchmark::requested(argc, argv))
+	{
+	  qup_benchmark benchmark(nullptr);
+
+	  return benchmark.exec();
+	}
+
+      qup_headless headless(nullptr);
+
+      return headless.exec();
+    }
 
   QApplication qapplication(argc, argv);
   auto font(qapplication.font());
@@ -54,6 +87,7 @@ int main(int argc, char *argv[])
     (QFont::StyleStrategy(QFont::PreferAntialias | QFont::PreferQuality));
   qapplication.setFont(font);
   qapplication.setWindowIcon(QIcon(":images/qup.png"));
+  qup::trace_startup("Application created");
 
   QDir dir;
 
@@ -73,8 +107,11 @@ int main(int argc, char *argv[])
   QSettings::setDefaultFormat(QSettings::IniFormat);
   QSettings::setPath
     (QSettings::IniFormat, QSettings::UserScope, qup::home_path());
+  qup::trace_startup("Settings prepared");
+
   qup qup;
 
   qup.show();
+  qup::trace_startup("Main window shown");
   return static_cast<int> (qapplication.exec());
 }
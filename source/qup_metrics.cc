@@ -0,0 +1,373 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QLocale>
+#include <QSaveFile>
+
+#include "qup_metrics.h"
+
+qup_metrics::qup_metrics(void)
+{
+  reset();
+}
+
+QJsonObject qup_metrics::json(const QString &product) const
+{
+  QMutexLocker locker(&m_mutex);
+  QJsonObject downloads;
+  QJsonObject first_byte;
+  QJsonObject object;
+  QJsonObject phases;
+  QJsonObject queue_wait;
+  auto const count = qMax(1LL, m_downloads);
+  auto const milliseconds = [](const qint64 nanoseconds)
+    {
+      return static_cast<double> (nanoseconds) / 1000000.0;
+    };
+
+  for(int i = 0; i < static_cast<int> (Phases::XYZ); i++)
+    {
+      if(m_duration[i] < 0)
+	continue;
+
+      QJsonObject phase;
+
+      phase["begin_ms"] = milliseconds(m_begin[i]);
+      phase["duration_ms"] = milliseconds(m_duration[i]);
+      phases[phase_name(static_cast<Phases> (i))] = phase;
+    }
+
+  first_byte["maximum"] = milliseconds(m_first_byte.m_maximum);
+  first_byte["mean"] = milliseconds(m_first_byte.m_total / count);
+  queue_wait["maximum"] = milliseconds(m_queue_wait.m_maximum);
+  queue_wait["mean"] = milliseconds(m_queue_wait.m_total / count);
+  downloads["bytes"] = m_bytes;
+  downloads["bytes_per_second"] = rate();
+  downloads["count"] = m_downloads;
+  downloads["failed"] = m_failed_downloads;
+  downloads["first_byte_ms"] = first_byte;
+  downloads["queue_wait_ms"] = queue_wait;
+  downloads["transfer_ms"] = milliseconds(m_transfer.m_total);
+  object["downloads"] = downloads;
+  object["phases"] = phases;
+  object["product"] = product;
+  object["started"] = QDateTime::fromMSecsSinceEpoch(m_started).
+    toString(Qt::ISODate);
+  return object;
+}
+
+QString qup_metrics::phase_name(const Phases phase)
+{
+  switch(phase)
+    {
+    case Phases::Download:
+      return "download";
+    case Phases::Gather:
+      return "gather";
+    case Phases::Hash:
+      return "hash";
+    case Phases::Install:
+      return "install";
+    case Phases::Manifest:
+      return "manifest";
+    case Phases::Parse:
+      return "parse";
+    default:
+      return "";
+    }
+}
+
+QString qup_metrics::prometheus(const QString &product) const
+{
+  /*
+  ** The text format of the node_exporter textfile collector.
+  */
+
+  QMutexLocker locker(&m_mutex);
+  QString label(product);
+  QString text("");
+  auto const count = qMax(1LL, m_downloads);
+  auto const seconds = [](const qint64 nanoseconds)
+    {
+      return QString::number
+	(static_cast<double> (nanoseconds) / 1000000000.0, 'f', 6);
+    };
+
+  label.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+  text.append("# HELP qup_phase_duration_seconds "
+	      "Duration of a phase of the most recent update.\n");
+  text.append("# TYPE qup_phase_duration_seconds gauge\n");
+
+  for(int i = 0; i < static_cast<int> (Phases::XYZ); i++)
+    if(m_duration[i] >= 0)
+      text.append
+	(QString("qup_phase_duration_seconds"
+		 "{product=\"%1\",phase=\"%2\"} %3\n").
+	 arg(label).
+	 arg(phase_name(static_cast<Phases> (i))).
+	 arg(seconds(m_duration[i])));
+
+  text.append("# HELP qup_downloaded_bytes "
+	      "Bytes downloaded by the most recent update.\n");
+  text.append("# TYPE qup_downloaded_bytes gauge\n");
+  text.append(QString("qup_downloaded_bytes{product=\"%1\"} %2\n").
+	      arg(label).arg(m_bytes));
+  text.append("# HELP qup_downloads "
+	      "Files requested by the most recent update.\n");
+  text.append("# TYPE qup_downloads gauge\n");
+  text.append(QString("qup_downloads{product=\"%1\",result=\"ok\"} %2\n").
+	      arg(label).arg(m_downloads - m_failed_downloads));
+  text.append
+    (QString("qup_downloads{product=\"%1\",result=\"failed\"} %2\n").
+     arg(label).arg(m_failed_downloads));
+  text.append("# HELP qup_download_first_byte_seconds "
+	      "Time between a request and its first byte.\n");
+  text.append("# TYPE qup_download_first_byte_seconds gauge\n");
+  text.append
+    (QString("qup_download_first_byte_seconds"
+	     "{product=\"%1\",statistic=\"mean\"} %2\n").
+     arg(label).arg(seconds(m_first_byte.m_total / count)));
+  text.append
+    (QString("qup_download_first_byte_seconds"
+	     "{product=\"%1\",statistic=\"maximum\"} %2\n").
+     arg(label).arg(seconds(m_first_byte.m_maximum)));
+  text.append("# HELP qup_download_queue_wait_seconds "
+	      "Time which a request waited for a connection.\n");
+  text.append("# TYPE qup_download_queue_wait_seconds gauge\n");
+  text.append
+    (QString("qup_download_queue_wait_seconds"
+	     "{product=\"%1\",statistic=\"mean\"} %2\n").
+     arg(label).arg(seconds(m_queue_wait.m_total / count)));
+  text.append
+    (QString("qup_download_queue_wait_seconds"
+	     "{product=\"%1\",statistic=\"maximum\"} %2\n").
+     arg(label).arg(seconds(m_queue_wait.m_maximum)));
+  text.append("# HELP qup_download_rate_bytes_per_second "
+	      "Bytes per second over the download phase.\n");
+  text.append("# TYPE qup_download_rate_bytes_per_second gauge\n");
+  text.append
+    (QString("qup_download_rate_bytes_per_second{product=\"%1\"} %2\n").
+     arg(label).
+     arg(rate(), 0, 'f', 0));
+  text.append("# HELP qup_update_start_time_seconds "
+	      "Start of the most recent update since the epoch.\n");
+  text.append("# TYPE qup_update_start_time_seconds gauge\n");
+  text.append
+    (QString("qup_update_start_time_seconds{product=\"%1\"} %2\n").
+     arg(label).arg(m_started / 1000));
+  return text;
+}
+
+QVector<QPair<QString, QString> > qup_metrics::rows(void) const
+{
+  QMutexLocker locker(&m_mutex);
+  QVector<QPair<QString, QString> > rows;
+  auto const count = qMax(1LL, m_downloads);
+  auto const milliseconds = [](const qint64 nanoseconds)
+    {
+      return QObject::tr("%1 ms").
+	arg(QLocale().toString
+	    (static_cast<double> (nanoseconds) / 1000000.0, 'f', 1));
+    };
+
+  rows << qMakePair
+    (QObject::tr("Manifest"),
+     m_duration[static_cast<int> (Phases::Manifest)] >= 0 ?
+     milliseconds(m_duration[static_cast<int> (Phases::Manifest)]) : "");
+  rows << qMakePair
+    (QObject::tr("Parse"),
+     m_duration[static_cast<int> (Phases::Parse)] >= 0 ?
+     milliseconds(m_duration[static_cast<int> (Phases::Parse)]) : "");
+  rows << qMakePair
+    (QObject::tr("Download"),
+     m_duration[static_cast<int> (Phases::Download)] >= 0 ?
+     milliseconds(m_duration[static_cast<int> (Phases::Download)]) : "");
+  rows << qMakePair
+    (QObject::tr("Install"),
+     m_duration[static_cast<int> (Phases::Install)] >= 0 ?
+     milliseconds(m_duration[static_cast<int> (Phases::Install)]) : "");
+  rows << qMakePair
+    (QObject::tr("Gather"),
+     m_duration[static_cast<int> (Phases::Gather)] >= 0 ?
+     milliseconds(m_duration[static_cast<int> (Phases::Gather)]) : "");
+  rows << qMakePair
+    (QObject::tr("Hash"),
+     m_duration[static_cast<int> (Phases::Hash)] >= 0 ?
+     milliseconds(m_duration[static_cast<int> (Phases::Hash)]) : "");
+  rows << qMakePair
+    (QObject::tr("Downloads"),
+     QObject::tr("%1 (%2 failed)").
+     arg(QLocale().toString(m_downloads)).
+     arg(QLocale().toString(m_failed_downloads)));
+  rows << qMakePair
+    (QObject::tr("Bytes"), QLocale().toString(m_bytes));
+  rows << qMakePair
+    (QObject::tr("Queue Wait (Mean / Maximum)"),
+     QString("%1 / %2").
+     arg(milliseconds(m_queue_wait.m_total / count)).
+     arg(milliseconds(m_queue_wait.m_maximum)));
+  rows << qMakePair
+    (QObject::tr("First Byte (Mean / Maximum)"),
+     QString("%1 / %2").
+     arg(milliseconds(m_first_byte.m_total / count)).
+     arg(milliseconds(m_first_byte.m_maximum)));
+  rows << qMakePair
+    (QObject::tr("Transfer Rate"),
+     QObject::tr("%1 KiB/s").
+     arg(QLocale().toString(rate() / 1024.0, 'f', 1)));
+  return rows;
+}
+
+bool qup_metrics::write(const QString &file_name, const QString &product) const
+{
+  /*
+  ** A .prom file receives the Prometheus text, other files receive
+  ** JSON. The file is replaced atomically so that collectors do not
+  ** read partial files.
+  */
+
+  QSaveFile file(file_name);
+
+  if(!file.open(QIODevice::WriteOnly))
+    return false;
+
+  if(file_name.endsWith(".prom"))
+    file.write(prometheus(product).toUtf8());
+  else
+    file.write(QJsonDocument(json(product)).toJson(QJsonDocument::Indented));
+
+  return file.commit();
+}
+
+double qup_metrics::rate(void) const
+{
+  /*
+  ** The aggregate throughput over the wall-clock download phase,
+  ** which is in progress if its duration is not known. The mutex is
+  ** held by the caller.
+  */
+
+  auto const i = static_cast<int> (Phases::Download);
+  auto const duration = m_duration[i] >= 0 ? m_duration[i] :
+    m_begin[i] >= 0 ? m_clock.nsecsElapsed() - m_begin[i] : 0;
+
+  return duration > 0 ?
+    1000000000.0 * static_cast<double> (m_bytes) /
+    static_cast<double> (duration) : 0.0;
+}
+
+qint64 qup_metrics::now(void) const
+{
+  QMutexLocker locker(&m_mutex);
+
+  return m_clock.nsecsElapsed();
+}
+
+void qup_metrics::add(const Phases phase, const qint64 duration)
+{
+  QMutexLocker locker(&m_mutex);
+  auto const i = static_cast<int> (phase);
+
+  if(i < 0 || i >= static_cast<int> (Phases::XYZ))
+    return;
+
+  if(m_duration[i] < 0)
+    {
+      m_begin[i] = m_clock.nsecsElapsed();
+      m_duration[i] = 0;
+    }
+
+  m_duration[i] += duration;
+}
+
+void qup_metrics::begin(const Phases phase)
+{
+  QMutexLocker locker(&m_mutex);
+  auto const i = static_cast<int> (phase);
+
+  if(i < 0 || i >= static_cast<int> (Phases::XYZ))
+    return;
+
+  m_begin[i] = m_clock.nsecsElapsed();
+  m_duration[i] = -1;
+}
+
+void qup_metrics::end(const Phases phase)
+{
+  QMutexLocker locker(&m_mutex);
+  auto const i = static_cast<int> (phase);
+
+  if(i < 0 || i >= static_cast<int> (Phases::XYZ) || m_begin[i] < 0)
+    return;
+
+  m_duration[i] = m_clock.nsecsElapsed() - m_begin[i];
+}
+
+void qup_metrics::record_download(const qint64 queued,
+				  const qint64 dispatched,
+				  const qint64 first_byte,
+				  const qint64 finished,
+				  const qint64 bytes,
+				  const bool ok)
+{
+  /*
+  ** Times are values of now(). A reply without a body has its first
+  ** byte at its completion.
+  */
+
+  QMutexLocker locker(&m_mutex);
+  auto const f = first_byte >= 0 ? first_byte : finished;
+
+  m_bytes += qMax(0LL, bytes);
+  m_downloads += 1;
+  m_failed_downloads += ok ? 0 : 1;
+  m_first_byte.add(qMax(0LL, f - dispatched));
+  m_queue_wait.add(qMax(0LL, dispatched - queued));
+  m_transfer.add(qMax(0LL, finished - f));
+}
+
+void qup_metrics::reset(void)
+{
+  QMutexLocker locker(&m_mutex);
+
+  for(int i = 0; i < static_cast<int> (Phases::XYZ); i++)
+    {
+      m_begin[i] = -1;
+      m_duration[i] = -1;
+    }
+
+  m_bytes = 0;
+  m_clock.start();
+  m_downloads = 0;
+  m_failed_downloads = 0;
+  m_first_byte = Statistic();
+  m_queue_wait = Statistic();
+  m_started = QDateTime::currentMSecsSinceEpoch();
+  m_transfer = Statistic();
+}
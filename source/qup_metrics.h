@@ -0,0 +1,110 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_metrics_h_
+#define _qup_metrics_h_
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+
+/*
+** Durations of an update's phases and statistics of its downloads.
+** Phases may overlap: requests are issued while the instruction file
+** is parsed, and pipelined installs accompany the downloads. Hash is
+** the cumulative digest time within Gather. Thread-safe.
+*/
+
+class qup_metrics
+{
+ public:
+  enum class Phases
+  {
+    Download = 0,
+    Gather,
+    Hash,
+    Install,
+    Manifest,
+    Parse,
+    XYZ
+  };
+
+  qup_metrics(void);
+  QJsonObject json(const QString &product) const;
+  QString prometheus(const QString &product) const;
+  QVector<QPair<QString, QString> > rows(void) const;
+  bool write(const QString &file_name, const QString &product) const;
+  qint64 now(void) const;
+  void add(const Phases phase, const qint64 duration);
+  void begin(const Phases phase);
+  void end(const Phases phase);
+  void record_download(const qint64 queued,
+		       const qint64 dispatched,
+		       const qint64 first_byte,
+		       const qint64 finished,
+		       const qint64 bytes,
+		       const bool ok);
+  void reset(void);
+
+ private:
+  class Statistic
+  {
+  public:
+    Statistic(void)
+    {
+      m_maximum = 0;
+      m_total = 0;
+    }
+
+    qint64 m_maximum; // Nanoseconds.
+    qint64 m_total; // Nanoseconds.
+
+    void add(const qint64 value)
+    {
+      m_maximum = qMax(m_maximum, value);
+      m_total += value;
+    }
+  };
+
+  QElapsedTimer m_clock;
+  mutable QMutex m_mutex;
+  Statistic m_first_byte;
+  Statistic m_queue_wait;
+  Statistic m_transfer;
+  qint64 m_begin[static_cast<int> (Phases::XYZ)]; // Nanoseconds.
+  qint64 m_bytes;
+  qint64 m_downloads;
+  qint64 m_duration[static_cast<int> (Phases::XYZ)]; // Nanoseconds.
+  qint64 m_failed_downloads;
+  qint64 m_started; // Milliseconds since the epoch.
+  double rate(void) const;
+  static QString phase_name(const Phases phase);
+};
+
+#endif
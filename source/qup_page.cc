@@ -25,155 +25,101 @@
 ** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFileDialog>
+#include <QHeaderView>
+#include <QScrollBar>
 #include <QMenu>
 #include <QMessageBox>
-#include <QNetworkReply>
-#include <QScrollBar>
-#include <QSettings>
-#include <QStandardPaths>
+#include <QRegularExpression>
 #include <QTimer>
 #include <QtConcurrent>
 
 #include "qup.h"
+#include "qup_favorites.h"
 #include "qup_page.h"
+#include "qup_scheduler.h"
+#include "qup_staging.h"
+#include "qup_trace.h"
 
-class PropertyNames
-{
- public:
-  char const static *AbsoluteFilePath;
-  char const static *DestinationDirectory;
-  char const static *DestinationFile;
-  char const static *Executable;
-  char const static *FileName;
-  char const static *Read;
-
- private:
-  PropertyNames(void);
-};
-
-char const *PropertyNames::AbsoluteFilePath = "absolute_file_path";
-char const *PropertyNames::DestinationDirectory = "destination_directory";
-char const *PropertyNames::DestinationFile = "destination_file";
-char const *PropertyNames::Executable = "executable";
-char const *PropertyNames::FileName = "file_name";
-char const *PropertyNames::Read = "read";
-char const static *const s_end_of_file = "# End of file. Required comment.";
-char const static *const s_shell_comment =
-  "# Here be special Qup instructions.";
 const int static s_activity_maximum_line_count = 100000;
-const int static s_maximum_size_of_instruction_buffer = 5 * 1024 * 1024;
-const int static s_populate_favorites_interval = 250;
+const int static s_files_resize_precision = 100; // Sampled rows.
+const int static s_gather_batch_interval = 50; // Milliseconds.
+const int static s_gather_batch_size = 256;
 
-qup_page::qup_page(QWidget *parent):QWidget(parent)
+qup_page::qup_page(qup_favorites *favorites,
+		   qup_journal *journal,
+		   QWidget *parent):QWidget(parent)
 {
-  m_copy_files_timer.setInterval(1500);
-  m_copy_files_timer.setSingleShot(true);
-  m_download_timer.setInterval(3600000);
+  m_activity_model = new qup_activity_model
+    (s_activity_maximum_line_count, this);
+  m_durability = qup_installer::Durabilities::Batched;
+  m_favorites = favorites;
+  m_files_generation = 0;
+  m_files_model = new qup_files_model(this);
+  m_activity_model->set_journal(journal);
   m_install_automatically = false;
-  m_ok = true;
+  m_install_mode = qup_installer::Modes::InPlace;
+  m_install_pipelined = false;
+  m_keep_staged_files = true;
+  m_prepared = false;
   m_tabs_menu_action = new QAction(tr("Download"), this);
-  m_ui.setupUi(this);
-  QTimer::singleShot
-    (s_populate_favorites_interval, this, &qup_page::slot_populate_favorites);
-  connect(&m_copy_files_timer,
-	  &QTimer::timeout,
-	  this,
-	  &qup_page::slot_copy_files);
+  m_updater = new qup_updater(this);
   connect(&m_copy_files_future_watcher,
 	  &QFutureWatcher<void>::finished,
 	  this,
 	  &qup_page::launch_file_gatherer);
-  connect(&m_download_timer,
-	  &QTimer::timeout,
-	  this,
-	  &qup_page::slot_download);
   connect(&m_timer,
 	  &QTimer::timeout,
 	  this,
 	  &qup_page::slot_timeout);
-  connect(m_ui.delete_favorite,
-	  &QToolButton::clicked,
+  connect(m_favorites,
+	  &qup_favorites::added,
 	  this,
-	  &qup_page::slot_delete_favorite);
-  connect(m_ui.download,
-	  &QToolButton::clicked,
+	  &qup_page::slot_favorite_added);
+  connect(m_favorites,
+	  &qup_favorites::removed,
 	  this,
-	  &qup_page::slot_download);
-  connect(m_ui.favorites,
-	  &QToolButton::clicked,
-	  m_ui.favorites,
-	  &QToolButton::showMenu);
-  connect(m_ui.install,
-	  &QToolButton::clicked,
-	  this,
-	  &qup_page::slot_install);
-  connect(m_ui.launch,
-	  &QPushButton::clicked,
-	  this,
-	  &qup_page::slot_launch);
-  connect(m_ui.refresh,
-	  &QPushButton::clicked,
+	  &qup_page::slot_favorite_removed);
+  connect(m_updater,
+	  &qup_updater::append,
 	  this,
-	  &qup_page::slot_refresh);
-  connect(m_ui.reset,
-	  &QPushButton::clicked,
-	  m_ui.activity,
-	  &QTextEdit::clear);
-  connect(m_ui.save_favorite,
-	  &QPushButton::clicked,
+	  &qup_page::append,
+	  Qt::DirectConnection);
+  connect(m_updater,
+	  &qup_updater::finished,
 	  this,
-	  &qup_page::slot_save_favorite);
-  connect(m_ui.select_local_directory,
-	  &QPushButton::clicked,
+	  &qup_page::slot_update_finished);
+  connect(m_updater,
+	  &qup_updater::instruction_file_saved,
 	  this,
-	  &qup_page::slot_select_local_directory);
+	  &qup_page::launch_file_gatherer);
   connect(this,
-	  SIGNAL(append_text(const QString &)),
+	  SIGNAL(files_gathered(const quint64,
+				const QByteArray &,
+				const bool)),
 	  this,
-	  SLOT(append(const QString &)));
+	  SLOT(slot_files_gathered(const quint64,
+				   const QByteArray &,
+				   const bool)));
   connect(this,
-	  SIGNAL(files_gathered(const QByteArray &,
-				const QVector<QVector<QString> > &)),
+	  SIGNAL(files_gathered_batch(const quint64,
+				      const QVector<qup_file> &)),
 	  this,
-	  SLOT(slot_populate_files_table(const QByteArray &,
-					 const QVector<QVector<QString> > &)));
-  m_network_access_manager.setRedirectPolicy
-    (QNetworkRequest::NoLessSafeRedirectPolicy);
-  m_timer.start(2500);
-  m_ui.activity_label->setText
-    (tr("Activity contents are removed after %1 lines.").
-     arg(QLocale().toString(s_activity_maximum_line_count)));
-  m_ui.favorites->setArrowType(Qt::NoArrow);
-  m_ui.favorites->setMenu(new QMenu(this));
-#ifdef Q_OS_MACOS
-#else
-  m_ui.favorites->setPopupMode(QToolButton::MenuButtonPopup);
-#endif
-#ifdef Q_OS_MACOS
-  m_ui.favorites->setStyleSheet
-    ("QToolButton {border: none;}"
-     "QToolButton::menu-button {border: none;}"
-     "QToolButton::menu-indicator {image: none;}");
-#endif
-  m_ui.refresh->setIcon(QIcon::fromTheme("view-refresh"));
-  m_ui.reset->setIcon(QIcon::fromTheme("edit-reset"));
-  m_ui.select_local_directory->setIcon(QIcon::fromTheme("document-open"));
-  prepare_operating_systems_widget();
+	  SLOT(slot_populate_files_table(const quint64,
+					 const QVector<qup_file> &)));
 }
 
 qup_page::~qup_page()
 {
   m_copy_files_future.cancel();
   m_copy_files_future.waitForFinished();
-  m_copy_files_timer.stop();
-  m_download_timer.stop();
   m_populate_files_table_future.cancel();
   m_populate_files_table_future.waitForFinished();
   m_timer.stop();
+  m_updater->interrupt();
 }
 
 QAction *qup_page::tabs_menu_action(void) const
@@ -181,62 +127,9 @@ QAction *qup_page::tabs_menu_action(void) const
   return m_tabs_menu_action;
 }
 
-QString qup_page::executable_suffix(void) const
+QString qup_page::product(void) const
 {
-  return QString(m_operating_system).replace(' ', '_').toLower();
-}
-
-QString qup_page::permissions_as_string
-(const QFileDevice::Permissions permissions)
-{
-  QString string("%1%2%3:%4%5%6:%7%8%9"); // Owner:Group:Other
-
-  if(permissions & QFileDevice::ExeGroup)
-    string.replace("%6", "x");
-  else
-    string.replace("%6", "-");
-
-  if(permissions & QFileDevice::ExeOther)
-    string.replace("%9", "x");
-  else
-    string.replace("%9", "-");
-
-  if(permissions & QFileDevice::ExeOwner)
-    string.replace("%3", "x");
-  else
-    string.replace("%3", "-");
-
-  if(permissions & QFileDevice::ReadGroup)
-    string.replace("%4", "r");
-  else
-    string.replace("%4", "-");
-
-  if(permissions & QFileDevice::ReadOther)
-    string.replace("%7", "r");
-  else
-    string.replace("%7", "-");
-
-  if(permissions & QFileDevice::ReadOwner)
-    string.replace("%1", "r");
-  else
-    string.replace("%1", "-");
-
-  if(permissions & QFileDevice::WriteGroup)
-    string.replace("%5", "w");
-  else
-    string.replace("%5", "-");
-
-  if(permissions & QFileDevice::WriteOther)
-    string.replace("%8", "w");
-  else
-    string.replace("%8", "-");
-
-  if(permissions & QFileDevice::WriteOwner)
-    string.replace("%2", "w");
-  else
-    string.replace("%2", "-");
-
-  return string;
+  return m_product;
 }
 
 QString qup_page::proper_path(const QString &path)
@@ -244,43 +137,18 @@ QString qup_page::proper_path(const QString &path)
   return QFileInfo(path).absoluteFilePath();
 }
 
-QUrl qup_page::string_as_url(const QString &s)
-{
-  auto string(s.trimmed());
-
-  while(string.contains("//"))
-    string.replace("//", "/");
-
-  if(string.endsWith("/"))
-    string = string.mid(0, string.length() - 1);
-
-  if(string.startsWith("ftp:/"))
-    string.replace(0, 5, "ftp://");
-  else if(string.startsWith("http:/"))
-    string.replace(0, 6, "http://");
-  else if(string.startsWith("https:/"))
-    string.replace(0, 7, "https://");
-
-  return QUrl::fromUserInput(string);
-}
-
 bool qup_page::active(void) const
 {
-  return m_copy_files_future.isRunning() ||
-    m_network_access_manager.findChildren<QNetworkReply *> ().size() > 0;
+  return m_copy_files_future.isRunning() || m_updater->active();
 }
 
 void qup_page::append(const QString &text)
 {
-  if(text.trimmed().isEmpty())
-    return;
+  /*
+  ** Thread-safe.
+  */
 
-  m_ui.activity->document()->lineCount() > s_activity_maximum_line_count ?
-    m_ui.activity->clear() : (void) 0;
-  m_ui.activity->append
-    (QString("<u>[%1]</u>: %2").
-     arg(QDateTime::currentDateTime().toString(Qt::ISODate)).
-     arg(text.trimmed()));
+  m_activity_model->append(text);
 }
 
 void qup_page::closeEvent(QCloseEvent *event)
@@ -291,315 +159,224 @@ void qup_page::closeEvent(QCloseEvent *event)
 void qup_page::copy_files
 (const QString &destination_path,
  const QString &local_path,
- const QString &product)
+ const QString &product,
+ const qup_installer::Modes mode,
+ const qup_installer::Durabilities durability,
+ const bool keep_staged_files)
+{
+  qup_trace::Span span("install", "Copy", product);
+  qup_installer installer(destination_path, local_path, product);
+
+  installer.set_append([this](const QString &text)
+		       {
+			 append(text);
+		       });
+  installer.set_canceled([this](void)
+			 {
+			   return m_copy_files_future.isCanceled();
+			 });
+  installer.set_durability(durability);
+  installer.set_keep_staged_files(keep_staged_files);
+  installer.set_mode(mode);
+  installer.install();
+}
+
+void qup_page::download(void)
 {
-  QDirIterator it
-    (local_path,
-     QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
-     QDirIterator::Subdirectories);
+  prepare_widgets();
+  slot_download();
+}
 
-  while(it.hasNext() && m_copy_files_future.isCanceled() == false)
+void qup_page::gather_files
+(const quint64 generation,
+ const QByteArray &super_hash,
+ const QString &destination_path,
+ const QString &local_path)
+{
+  /*
+  ** Files are delivered in bounded batches so that the table may be
+  ** populated while the remaining files are being hashed. The
+  ** destination is visited first and then the temporary directory
+  ** for files which have not been installed. If a previous super hash
+  ** is known, the batches are retained and delivered only if the super
+  ** hash has changed.
+  */
+
+  qup_trace::Span span("gather", "Gather");
+  QCryptographicHash sha3_512(QCryptographicHash::Sha3_512);
+  QElapsedTimer timer;
+  QVector<QVector<qup_file> > retained;
+  QVector<qup_file> data;
+  auto const metrics(m_updater->metrics());
+  auto const digest = [&metrics](const QString &file_name)
     {
-      it.next();
+      qup_trace::Span trace("gather", "Hash");
+      QElapsedTimer elapsed;
 
-      auto const file_information(it.fileInfo());
+      elapsed.start();
 
-      if(file_information.isDir())
+      auto const value(qup_files::file_digest(file_name));
+
+      metrics->add(qup_metrics::Phases::Hash, elapsed.nsecsElapsed());
+      return value;
+    };
+  auto const flush = [&](const bool force)
+    {
+      if(data.isEmpty())
+	return;
+
+      if(force ||
+	 data.size() >= s_gather_batch_size ||
+	 timer.elapsed() >= s_gather_batch_interval)
 	{
-	  auto destination(destination_path);
+	  qup_trace::instant("gather", "Batch");
 
-	  destination.append(QDir::separator());
-	  destination.append
-	    (file_information.absoluteFilePath().remove(local_path));
-	  destination = proper_path(destination);
+	  if(super_hash.isEmpty())
+	    emit files_gathered_batch(generation, data);
+	  else
+	    retained << data;
 
-	  if(!QFileInfo(destination).exists())
-	    {
-	      QString text("");
+	  data.clear();
+	  data.reserve(s_gather_batch_size);
+	  timer.restart();
+	}
+    };
+  auto const gather = [&](qup_file &file)
+    {
+      sha3_512.addData(file.m_relative_path.toUtf8());
+      sha3_512.addData
+	(QByteArray::fromRawData
+	 (reinterpret_cast<const char *> (file.m_local_digest.data()),
+	  static_cast<int> (file.m_local_digest.size())));
+      sha3_512.addData(QByteArray::number(file.m_local_permissions));
+      sha3_512.addData
+	(QByteArray::fromRawData
+	 (reinterpret_cast<const char *> (file.m_temporary_digest.data()),
+	  static_cast<int> (file.m_temporary_digest.size())));
+      sha3_512.addData(QByteArray::number(file.m_temporary_permissions));
+      sha3_512.addData(QByteArray::number(file.m_flags));
+      data << file;
+      flush(false);
+    };
+
+  data.reserve(s_gather_batch_size);
+  metrics->begin(qup_metrics::Phases::Gather);
+  metrics->begin(qup_metrics::Phases::Hash);
+  timer.start();
 
-	      text.append(tr("Creating %1... ").arg(destination));
+  /*
+  ** Relative paths are separated by '/' and lack a leading separator.
+  */
 
-	      if(QDir().mkpath(destination))
-		text.append(tr("<font color='darkgreen'>Created.</font>"));
-	      else
-		text.append(tr("<font color='darkred'>Failure.</font>"));
+  if(!destination_path.isEmpty() && QFileInfo(destination_path).isDir())
+    {
+      QDir const directory(destination_path);
+      QDirIterator it
+	(destination_path,
+	 QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
+	 QDirIterator::Subdirectories);
+
+      while(it.hasNext() &&
+	    m_populate_files_table_future.isCanceled() == false)
+	{
+	  it.next();
 
-	      emit append_text(text);
+	  auto const file_information(it.fileInfo());
+
+	  if(!file_information.isFile())
+	    {
+	      flush(false);
+	      continue;
 	    }
-	}
-      else
-	{
-	  QString destination("");
 
-	  destination.append(destination_path);
-	  destination.append(QDir::separator());
-	  destination.append
-	    (file_information.absoluteFilePath().remove(local_path));
-	  destination = proper_path(destination);
+	  qup_file file;
 
-	  if(QFileInfo(destination).exists())
-	    QFile::remove(destination);
+	  file.m_relative_path = directory.relativeFilePath
+	    (file_information.absoluteFilePath());
 
-	  QString text("");
+	  QFileInfo const temporary_file_information
+	    (proper_path(local_path + QDir::separator() + file.m_relative_path));
 
-	  text.append
-	    (tr("Copying %1 to %2... ").
-	     arg(file_information.absoluteFilePath()).
-	     arg(destination));
+	  file.m_local_digest = digest(file_information.absoluteFilePath());
+	  file.m_local_permissions = static_cast<quint16>
+	    (file_information.permissions());
 
-	  if(QFile::copy(file_information.absoluteFilePath(), destination))
+	  if(temporary_file_information.isFile())
 	    {
-	      text.append(tr("<font color='darkgreen'>Copied.</font>"));
-	      emit append_text(text);
-	      text.clear();
-	      text.append
-		(tr("Setting permissions on %1... ").arg(destination));
-
-	      QFile file(destination);
-
-	      if(file.
-		 setPermissions(QFileInfo(file_information.
-					  absoluteFilePath()).permissions()))
-		text.append(tr("<font color='darkgreen'>Success.</font>"));
-	      else
-		text.append(tr("<font color='darkred'>Failure.</font>"));
-
-	      emit append_text(text);
+	      file.m_temporary_digest = digest
+		(temporary_file_information.absoluteFilePath());
+	      file.m_temporary_permissions = static_cast<quint16>
+		(temporary_file_information.permissions());
 	    }
 	  else
-	    {
-	      text.append(tr("<font color='darkred'>Failure.</font>"));
-	      emit append_text(text);
-	    }
+	    file.m_flags |= qup_file::TemporaryMissing;
 
-	  if(file_information.suffix() == "desktop")
-	    {
-	      auto destination
-		(QStandardPaths::
-		 writableLocation(QStandardPaths::DesktopLocation));
-
-	      if(destination.isEmpty() == false)
-		{
-		  QDir().mkpath(destination);
-		  destination.append(QDir::separator());
-		  destination.append(file_information.fileName());
-		  destination = proper_path(destination);
-
-		  if(QFileInfo(destination).exists())
-		    QFile::remove(destination);
-
-		  QString text("");
-
-		  text.append
-		    (tr("Copying %1 to %2... ").
-		     arg(file_information.absoluteFilePath()).
-		     arg(destination));
-
-		  if(QFile::copy(file_information.absoluteFilePath(),
-				 destination))
-		    {
-		      text.append
-			(tr("<font color='darkgreen'>Copied.</font>"));
-		      emit append_text(text);
-		      text.clear();
-		      text.append
-			(tr("Setting permissions on %1... ").arg(destination));
-
-		      QFile file(destination);
-
-		      if(file.setPermissions(QFileInfo(file_information.
-						       absoluteFilePath()).
-					     permissions()))
-			text.append
-			  (tr("<font color='darkgreen'>Success.</font>"));
-		      else
-			text.append
-			  (tr("<font color='darkred'>Failure.</font>"));
-
-		      emit append_text(text);
-		    }
-		  else
-		    {
-		      text.append
-			(tr("<font color='darkred'>Failure.</font>"));
-		      emit append_text(text);
-		    }
-		}
-	      else
-		{
-		  QString text("");
-
-		  text.append
-		    (tr("<font color='darkred'>A Desktop location is "
-			"not defined.</font>"));
-		  emit append_text(text);
-		}
-	    }
-
-	  prepare_shell_file
-	    (destination_path, file_information.absoluteFilePath(), product);
+	  gather(file);
 	}
     }
 
-  foreach(auto const &string, QStringList() << ".bash" << ".sh")
+  if(!local_path.isEmpty() && QFileInfo(local_path).isDir())
     {
-      auto const shell_file_name
-	(QString("%1%2%3%4").
-	 arg(destination_path).
-	 arg(QDir::separator()).
-	 arg(product.toLower()).
-	 arg(string));
-      auto const temporary_shell_file_name(shell_file_name + ".qup_temporary");
-
-      if(QFileInfo::exists(temporary_shell_file_name))
+      QDir const directory(local_path);
+      auto const marker(qup_staging::marker(local_path));
+      QDirIterator it
+	(local_path,
+	 QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
+	 QDirIterator::Subdirectories);
+
+      while(it.hasNext() &&
+	    m_populate_files_table_future.isCanceled() == false)
 	{
-	  QFile::remove(shell_file_name);
-	  QFile::rename(temporary_shell_file_name, shell_file_name);
-	  QFile::remove(temporary_shell_file_name);
+	  it.next();
 
-	  QFile file(shell_file_name);
+	  auto const file_information(it.fileInfo());
 
-	  file.setPermissions(QFileDevice::ExeOwner | file.permissions());
-	  break;
-	}
-    }
-}
-
-void qup_page::download_files(const QHash<QString, FileInformation> &files,
-			      const QString &directory_destination,
-			      const QString &file_destination,
-			      const QUrl &url)
-{
-  if(files.isEmpty() || url.isEmpty() || url.isValid() == false)
-    return;
-
-  QHashIterator<QString, FileInformation> it(files);
+	  if(!file_information.isFile() ||
+	     file_information.absoluteFilePath() == marker)
+	    {
+	      flush(false);
+	      continue;
+	    }
 
-  while(it.hasNext())
-    {
-      it.next();
-
-      if(it.key().trimmed().isEmpty())
-	continue;
-
-      QNetworkReply *reply = nullptr;
-      auto const dot = it.value().m_destination == "." ||
-	it.value().m_destination.startsWith("./");
-      auto remote_file_name(url.toString());
-
-      remote_file_name.append('/');
-      remote_file_name.append(it.key());
-      append(tr("Downloading %1.").arg(remote_file_name));
-      reply = m_network_access_manager.get
-	(QNetworkRequest(string_as_url(remote_file_name)));
-      reply->ignoreSslErrors();
-      reply->setProperty
-	(PropertyNames::DestinationDirectory, dot ? "" : directory_destination);
-      reply->setProperty
-	(PropertyNames::DestinationFile, dot ? it.key() : file_destination);
-      reply->setProperty(PropertyNames::Executable, it.value().m_executable);
-      reply->setProperty
-	(PropertyNames::FileName, QFileInfo(it.key()).fileName());
-      connect(reply,
-	      &QNetworkReply::finished,
-	      this,
-	      &qup_page::slot_reply_finished);
-      connect(reply,
-	      &QNetworkReply::readyRead,
-	      this,
-	      &qup_page::slot_write_file);
-    }
-}
+	  auto const relative_path
+	    (directory.relativeFilePath(file_information.absoluteFilePath()));
 
-void qup_page::gather_files
-(const QByteArray &super_hash,
- const QString &destination_path,
- const QString &local_path)
-{
-  QCryptographicHash sha3_512(QCryptographicHash::Sha3_512);
-  QDirIterator it
-    (destination_path,
-     QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
-     QDirIterator::Subdirectories);
-  QVector<QVector<QString> > data;
+	  if(QFileInfo(proper_path(destination_path +
+				   QDir::separator() +
+				   relative_path)).isFile())
+	    continue;
 
-  while(it.hasNext() && m_populate_files_table_future.isCanceled() == false)
-    {
-      it.next();
+	  qup_file file;
 
-      auto const file_information(it.fileInfo());
+	  file.m_flags |= qup_file::LocalMissing;
+	  file.m_relative_path = relative_path;
+	  file.m_temporary_digest = digest(file_information.absoluteFilePath());
+	  file.m_temporary_permissions = static_cast<quint16>
+	    (file_information.permissions());
+	  gather(file);
+	}
+    }
 
-      if(file_information.isFile())
-	{
-	  QString file_name
-	    (file_information.absoluteFilePath().remove(destination_path));
-	  QVector<QString> vector(static_cast<int> (FilesColumns::XYZ));
-
-	  {
-	    QCryptographicHash sha3_256(QCryptographicHash::Sha3_256);
-	    QFile file(file_information.absoluteFilePath());
-
-	    if(file.open(QIODevice::ReadOnly))
-	      {
-		sha3_256.addData(&file);
-		file.close();
-	      }
-
-	    vector[static_cast<int> (FilesColumns::LocalFileDigest)] =
-	      sha3_256.result().toHex();
-	  }
-
-	  {
-	    QCryptographicHash sha3_256(QCryptographicHash::Sha3_256);
-	    QFile file;
-
-	    file.setFileName
-	      (proper_path(local_path + QDir::separator() + file_name));
-
-	    if(file.open(QIODevice::ReadOnly))
-	      {
-		sha3_256.addData(&file);
-		file.close();
-	      }
-
-	    vector[static_cast<int> (FilesColumns::TemporaryFileDigest)] =
-	      sha3_256.result().toHex();
-	  }
-
-	  vector[static_cast<int> (FilesColumns::LocalFileName)] =
-	    file_information.absoluteFilePath();
-	  vector[static_cast<int> (FilesColumns::LocalFilePermissions)] =
-	    permissions_as_string(file_information.permissions());
+  if(m_populate_files_table_future.isCanceled() == false)
+    flush(true);
 
-	  QFileInfo const temporary_file_information
-	    (proper_path(local_path + QDir::separator() + file_name));
+  auto const hash(sha3_512.result());
 
-	  vector[static_cast<int> (FilesColumns::TemporaryFileName)] =
-	    temporary_file_information.absoluteFilePath();
-	  vector[static_cast<int> (FilesColumns::TemporaryFilePermissions)] =
-	    permissions_as_string(temporary_file_information.permissions());
-	  data << vector;
+  if(hash != super_hash && m_populate_files_table_future.isCanceled() == false)
+    foreach(auto const &batch, retained)
+      emit files_gathered_batch(generation, batch);
 
-	  foreach(auto const &i, vector)
-	    sha3_512.addData(i.toUtf8());
-	}
-    }
+  metrics->end(qup_metrics::Phases::Gather);
 
-  if(m_populate_files_table_future.isCanceled() == false &&
-     sha3_512.result() != super_hash)
-    emit files_gathered(sha3_512.result(), data);
+  emit files_gathered
+    (generation, hash, m_populate_files_table_future.isCanceled() == false);
 }
 
 void qup_page::interrupt(void)
 {
-  foreach(auto reply,
-	  m_network_access_manager.findChildren<QNetworkReply *> ())
-    if(reply)
-      reply->abort();
-
+  m_updater->interrupt();
   m_copy_files_future.cancel();
   m_copy_files_future.waitForFinished();
-  m_download_timer.stop();
   m_populate_files_table_future.cancel();
   m_populate_files_table_future.waitForFinished();
   qDebug() << tr("Interrupted.");
@@ -607,16 +384,65 @@ void qup_page::interrupt(void)
 
 void qup_page::launch_file_gatherer(void)
 {
-  if(m_populate_files_table_future.isFinished())
+  if(!m_prepared || m_populate_files_table_future.isFinished() == false)
+    return;
+
+  m_files_generation += 1;
+  m_files_model->begin_merge();
+  m_files_model->set_paths(m_destination, m_path);
+  m_ui.files_progress->setVisible(true);
 #if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
-    m_populate_files_table_future = QtConcurrent::run
-      (this, &qup_page::gather_files, m_super_hash, m_destination, m_path);
+  m_populate_files_table_future = QtConcurrent::run
+    (this,
+     &qup_page::gather_files,
+     m_files_generation,
+     m_super_hash,
+     m_destination,
+     m_path);
 #else
-    m_populate_files_table_future = QtConcurrent::run
-      (&qup_page::gather_files, this, m_super_hash, m_destination, m_path);
+  m_populate_files_table_future = QtConcurrent::run
+    (&qup_page::gather_files,
+     this,
+     m_files_generation,
+     m_super_hash,
+     m_destination,
+     m_path);
 #endif
 }
 
+void qup_page::populate_favorites(void)
+{
+  m_ui.favorites->menu()->clear();
+
+  foreach(auto const &name, m_favorites->names())
+    m_ui.favorites->menu()->addAction
+      (name, this, &qup_page::slot_populate_favorite);
+
+  m_ui.favorites->setEnabled(!m_ui.favorites->menu()->isEmpty());
+}
+
+void qup_page::populate_metrics(void)
+{
+  if(!m_prepared)
+    return;
+
+  auto const rows(m_updater->metrics()->rows());
+
+  m_ui.metrics->setRowCount(rows.size());
+
+  for(int i = 0; i < rows.size(); i++)
+    for(int j = 0; j < 2; j++)
+      {
+	auto const text(j == 0 ? rows.at(i).first : rows.at(i).second);
+	auto item = m_ui.metrics->item(i, j);
+
+	item ? item->setText(text) :
+	  m_ui.metrics->setItem(i, j, new QTableWidgetItem(text));
+      }
+
+  m_ui.metrics->resizeColumnToContents(0);
+}
+
 void qup_page::prepare_operating_systems_widget(void)
 {
   m_ui.operating_system->clear();
@@ -666,85 +492,121 @@ void qup_page::prepare_operating_systems_widget(void)
      0 : m_ui.operating_system->currentIndex());
 }
 
-void qup_page::prepare_shell_file
-(const QString &destination_path, const QString &path, const QString &product)
+void qup_page::prepare_widgets(void)
 {
-  QFileInfo const file_information(path);
-  auto const file_name(file_information.fileName().toLower());
+  /*
+  ** The widgets are created once the page is first shown.
+  */
 
-  if(!(file_name == product.toLower() + ".bash" ||
-       file_name == product.toLower() + ".sh"))
+  if(m_prepared)
     return;
 
-  QFile file(path);
-  QFile temporary(path + ".qup_temporary");
-
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text) &&
-     temporary.open(QIODevice::Text |
-		    QIODevice::Truncate |
-		    QIODevice::WriteOnly))
-    {
-      QByteArray data(4096, '0');
-      qint64 rc = 0;
-
-      while((rc = file.readLine(data.data(),
-				static_cast<qint64> (data.length()))) > 0)
-	{
-	  temporary.write(data.mid(0, static_cast<int> (rc)));
-
-	  if(data.mid(0, static_cast<int> (rc)).trimmed() == s_shell_comment)
-	    {
-	      QString text("");
-
-	      if(path.toLower().trimmed().endsWith(".sh"))
-		{
-		  text.append("\n");
-		  text.append
-		    (QString("if [ -r %1/%2 ] && [ -x %1/%2 ]\n").
-		     arg(proper_path(destination_path)).arg(product));
-		  text.append("then\n");
-		  text.append
-		    (QString("    echo \"Launching an official %1.\"\n").
-		     arg(product));
-		  text.append
-		    (QString("    cd %1 && exec ./%2 \"$qup_arguments\" "
-			     "\"$@\"\n").
-		     arg(proper_path(destination_path)).arg(product));
-		  text.append("    exit $?\n");
-		  text.append("fi\n\n");
-		}
-
-	      if(text.length() > 0)
-		temporary.write(text.toUtf8());
-	    }
-	}
-    }
+  m_prepared = true;
+  m_ui.setupUi(this);
+  m_ui.activity->setModel(m_activity_model);
+  m_ui.files->horizontalHeader()->setResizeContentsPrecision
+    (s_files_resize_precision);
+  m_ui.files->setModel(m_files_model);
+  m_ui.files->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  connect(m_ui.delete_favorite,
+	  &QToolButton::clicked,
+	  this,
+	  &qup_page::slot_delete_favorite);
+  connect(m_ui.download,
+	  &QToolButton::clicked,
+	  this,
+	  &qup_page::slot_download);
+  connect(m_files_model,
+	  &qup_files_model::counts_changed,
+	  this,
+	  &qup_page::slot_files_counts_changed);
+  connect(m_ui.favorites,
+	  &QToolButton::clicked,
+	  m_ui.favorites,
+	  &QToolButton::showMenu);
+  connect(m_ui.export_metrics_json,
+	  &QPushButton::clicked,
+	  this,
+	  &qup_page::slot_export_metrics);
+  connect(m_ui.export_metrics_prometheus,
+	  &QPushButton::clicked,
+	  this,
+	  &qup_page::slot_export_metrics);
+  connect(m_ui.files_filter,
+	  SIGNAL(currentIndexChanged(int)),
+	  this,
+	  SLOT(slot_files_filter(int)));
+  connect(m_ui.install,
+	  &QToolButton::clicked,
+	  this,
+	  &qup_page::slot_install);
+  connect(m_ui.launch,
+	  &QPushButton::clicked,
+	  this,
+	  &qup_page::slot_launch);
+  connect(m_ui.refresh,
+	  &QPushButton::clicked,
+	  this,
+	  &qup_page::slot_refresh);
+  connect(m_activity_model,
+	  &qup_activity_model::rowsInserted,
+	  this,
+	  &qup_page::slot_activity_inserted);
+  connect(m_ui.reset,
+	  &QPushButton::clicked,
+	  m_activity_model,
+	  &qup_activity_model::clear);
+  connect(m_ui.save_favorite,
+	  &QPushButton::clicked,
+	  this,
+	  &qup_page::slot_save_favorite);
+  connect(m_ui.select_local_directory,
+	  &QPushButton::clicked,
+	  this,
+	  &qup_page::slot_select_local_directory);
+  connect(m_ui.select_staging_directory,
+	  &QPushButton::clicked,
+	  this,
+	  &qup_page::slot_select_staging_directory);
+  m_timer.start(2500);
+  m_ui.activity_label->setText
+    (tr("The most recent %1 lines of activity are retained.").
+     arg(QLocale().toString(s_activity_maximum_line_count)));
+  m_ui.favorites->setArrowType(Qt::NoArrow);
+  slot_files_counts_changed();
+  m_ui.files_progress->setVisible(false);
+  m_ui.favorites->setMenu(new QMenu(this));
+#ifdef Q_OS_MACOS
+#else
+  m_ui.favorites->setPopupMode(QToolButton::MenuButtonPopup);
+#endif
+#ifdef Q_OS_MACOS
+  m_ui.favorites->setStyleSheet
+    ("QToolButton {border: none;}"
+     "QToolButton::menu-button {border: none;}"
+     "QToolButton::menu-indicator {image: none;}");
+#endif
+  m_ui.refresh->setIcon(QIcon::fromTheme("view-refresh"));
+  m_ui.reset->setIcon(QIcon::fromTheme("edit-reset"));
+  m_ui.select_local_directory->setIcon(QIcon::fromTheme("document-open"));
+  m_ui.select_staging_directory->setIcon(QIcon::fromTheme("document-open"));
+  populate_favorites();
+  populate_metrics();
+  prepare_operating_systems_widget();
+}
 
-  file.close();
-  temporary.close();
+void qup_page::showEvent(QShowEvent *event)
+{
+  prepare_widgets();
+  QWidget::showEvent(event);
 }
 
-void qup_page::slot_copy_files(void)
+void qup_page::slot_activity_inserted(void)
 {
-  if(m_network_access_manager.findChildren<QNetworkReply *> ().size() > 0 &&
-     m_ok)
-    {
-      m_copy_files_timer.start();
-      return;
-    }
-  else if(m_copy_files_future.isFinished() == false ||
-	  m_ok == false ||
-	  m_product.isEmpty())
-    {
-      m_copy_files_timer.stop();
-      return;
-    }
+  auto const scroll_bar = m_ui.activity->verticalScrollBar();
 
-  append
-    (tr("<font color='darkgreen'>You may now install %1!</font>").
-     arg(m_product));
-  launch_file_gatherer();
-  m_install_automatically ? m_ui.install->click() : (void) 0;
+  if(scroll_bar->value() >= scroll_bar->maximum() - scroll_bar->pageStep())
+    m_ui.activity->scrollToBottom();
 }
 
 void qup_page::slot_delete_favorite(void)
@@ -774,20 +636,8 @@ void qup_page::slot_delete_favorite(void)
 
   QApplication::processEvents();
 
-  QSettings settings;
-
-  settings.beginGroup(QString("favorite-%1").arg(name));
-  settings.remove("");
-  settings.endGroup(); // Optional.
-
-  if(settings.status() == QSettings::NoError)
-    {
-      QTimer::singleShot(s_populate_favorites_interval,
-			 this,
-			 &qup_page::slot_populate_favorites);
-      emit populate_favorites();
-      interrupt();
-    }
+  if(m_favorites->remove(name))
+    interrupt();
   else
     append(tr("<font color='darkred'>Could not delete %1.</font>").arg(name));
 }
@@ -821,7 +671,8 @@ void qup_page::slot_download(void)
       return;
     }
 
-  auto const url(string_as_url(m_ui.qup_txt_location->text().trimmed()));
+  auto const url
+    (qup_updater::string_as_url(m_ui.qup_txt_location->text().trimmed()));
 
   if(url.isEmpty() || url.isValid() == false)
     {
@@ -831,56 +682,109 @@ void qup_page::slot_download(void)
       return;
     }
 
-  m_destination = m_ui.local_directory->text().trimmed();
-  m_operating_system = m_ui.operating_system->currentText();
-  m_path = QDir::tempPath();
-  m_path.append(QDir::separator());
-  m_path.append("qup-");
-  m_path.append(name);
-  m_path = proper_path(m_path);
+  qup_updater::Favorite favorite;
+
+  favorite.m_destination = local_directory;
+  favorite.m_durability = m_durability;
+  favorite.m_install_automatically = m_install_automatically;
+  favorite.m_install_mode = m_install_mode;
+  favorite.m_install_pipelined = m_install_pipelined;
+  favorite.m_keep_staged_files = m_keep_staged_files;
+  favorite.m_name = name;
+  favorite.m_operating_system = m_ui.operating_system->currentText();
+  favorite.m_staging_directory = m_ui.staging_directory->text().trimmed();
+  favorite.m_staging_quota = 1048576LL * static_cast<qint64>
+    (m_ui.staging_quota->value());
+  favorite.m_url = url;
+  m_destination = local_directory;
+  m_activity_model->set_journal_name(name);
   m_product = name;
+  m_updater->download(favorite);
+  m_path = m_updater->path();
+}
+
+void qup_page::slot_export_metrics(void)
+{
+  auto const prometheus = m_ui.export_metrics_prometheus == sender();
+  auto const suffix(prometheus ? "prom" : "json");
+  QFileDialog dialog(this);
 
-  if(!QFileInfo(m_path).exists())
+  dialog.setAcceptMode(QFileDialog::AcceptSave);
+  dialog.setDefaultSuffix(suffix);
+  dialog.setDirectory(QDir::homePath());
+  dialog.setFileMode(QFileDialog::AnyFile);
+  dialog.setLabelText(QFileDialog::Accept, tr("Save"));
+  dialog.setNameFilter
+    (prometheus ? tr("Prometheus (*.prom)") : tr("JSON (*.json)"));
+  dialog.setWindowTitle(tr("Qup: Export Metrics"));
+  dialog.selectFile
+    (QString("qup_%1.%2").
+     arg(QString(m_product).
+	 replace(QRegularExpression("[^0-9A-Za-z._-]"), "_")).
+     arg(suffix));
+
+  if(dialog.exec() == QDialog::Accepted)
     {
-      auto text(tr("<b>Creating %1... </b>").arg(m_path));
+      QApplication::processEvents();
 
-      if(QDir().mkpath(m_path) == false)
-	{
-	  text.append(tr("<font color='darkred'>Failure.</font>"));
-	  append(text);
-	  return;
-	}
-      else
-	text.append(tr("<font color='darkgreen'>Created.</font>"));
+      auto const file_name(dialog.selectedFiles().value(0));
 
-      append(text);
+      if(m_updater->metrics()->write(file_name, m_product))
+	append(tr("<font color='darkgreen'>The metrics were exported to "
+		  "%1.</font>").arg(file_name));
+      else
+	append(tr("<font color='darkred'>The metrics could not be "
+		  "exported to %1.</font>").arg(file_name));
     }
   else
-    append(tr("The destination path %1 exists.").arg(m_path));
+    QApplication::processEvents();
+}
+
+void qup_page::slot_favorite_added(const QString &name)
+{
+  if(!m_prepared)
+    return;
 
   /*
-  ** Download the instructions file.
+  ** The menu remains sorted.
   */
 
-  append(tr("<b>Downloading the file %1.</b>").arg(url.toString()));
-  m_instruction_file_reply = m_network_access_manager.get(QNetworkRequest(url));
-  m_instruction_file_reply_data.clear();
-  m_ok = true;
-  m_qup_txt_file_name = m_path + QDir::separator() + url.fileName();
-  m_qup_txt_file_name = proper_path(m_qup_txt_file_name);
-  connect(m_instruction_file_reply,
-	  &QNetworkReply::finished,
-	  this,
-	  &qup_page::slot_instruction_reply_finished);
-  connect(m_instruction_file_reply,
-	  &QNetworkReply::readyRead,
+  auto action = new QAction(name, m_ui.favorites->menu());
+  QAction *before = nullptr;
+
+  foreach(auto a, m_ui.favorites->menu()->actions())
+    if(a->text() > name)
+      {
+	before = a;
+	break;
+      }
+
+  connect(action,
+	  &QAction::triggered,
 	  this,
-	  &qup_page::slot_write_instruction_file_data);
+	  &qup_page::slot_populate_favorite);
+  m_ui.favorites->menu()->insertAction(before, action);
+  m_ui.favorites->setEnabled(true);
+}
+
+void qup_page::slot_favorite_removed(const QString &name)
+{
+  if(!m_prepared)
+    return;
+
+  foreach(auto action, m_ui.favorites->menu()->actions())
+    if(action->text() == name)
+      {
+	m_ui.favorites->menu()->removeAction(action);
+	action->deleteLater();
+      }
+
+  m_ui.favorites->setEnabled(!m_ui.favorites->menu()->isEmpty());
 }
 
 void qup_page::slot_install(void)
 {
-  if(m_copy_files_future.isRunning())
+  if(m_copy_files_future.isRunning() || m_updater->active())
     {
       append
 	(tr("<font color='darkred'>Downloaded files are being copied. Please "
@@ -917,28 +821,24 @@ void qup_page::slot_install(void)
       append(text);
     }
 
-#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
-  m_copy_files_future = QtConcurrent::run
-    (this, &qup_page::copy_files, m_destination, m_path, m_product);
-#else
-  m_copy_files_future = QtConcurrent::run
-    (&qup_page::copy_files, this, m_destination, m_path, m_product);
-#endif
-  m_copy_files_future_watcher.setFuture(m_copy_files_future);
-}
+  /*
+  ** QtConcurrent::run() of Qt 5 accepts at most five arguments.
+  */
 
-void qup_page::slot_instruction_reply_finished(void)
-{
-  if(m_instruction_file_reply)
-    {
-      if(m_instruction_file_reply->error() != QNetworkReply::NoError)
-	append
-	  (tr("<font color='darkred'>Could not download %1. Perhaps "
-	      "the file does not exist.</font>").
-	   arg(m_instruction_file_reply->url().toString()));
+  auto const destination(m_destination);
+  auto const durability = m_durability;
+  auto const keep_staged_files = m_keep_staged_files;
+  auto const mode = m_install_mode;
+  auto const path(m_path);
+  auto const product(m_product);
 
-      m_instruction_file_reply->deleteLater();
-    }
+  m_copy_files_future = QtConcurrent::run
+    ([=](void)
+     {
+       copy_files
+	 (destination, path, product, mode, durability, keep_staged_files);
+     });
+  m_copy_files_future_watcher.setFuture(m_copy_files_future);
 }
 
 void qup_page::slot_launch(void)
@@ -1001,185 +901,6 @@ void qup_page::slot_launch(void)
        arg(executable));
 }
 
-void qup_page::slot_parse_instruction_file(void)
-{
-  if(m_qup_txt_file_name.trimmed().isEmpty())
-    return;
-
-  QFile file(m_qup_txt_file_name);
-
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-      QHash<QString, qup_page::FileInformation> files;
-      QString file_destination("");
-      QString line("");
-      QTextStream stream(&file);
-      auto general = false;
-      auto unix = false;
-
-      while(!stream.atEnd())
-	{
-	  if(line.endsWith('\\'))
-	    {
-	      auto l(stream.readLine().trimmed());
-	      auto const p = l.indexOf('#');
-
-	      if(p >= 0)
-		l = l.mid(0, p).trimmed();
-
-	      line.remove('\\');
-	      line.append(l);
-	    }
-	  else
-	    line = stream.readLine().trimmed();
-
-	  auto const position = line.indexOf('#');
-
-	  if(position >= 0)
-	    line = line.mid(0, position).trimmed();
-
-	  if(line.endsWith('\\') || line.isEmpty())
-	    continue;
-
-	  if(line == "[General]")
-	    {
-	      general = true;
-	      continue;
-	    }
-	  else if(line == "[Unix]")
-	    {
-#ifdef Q_OS_MACOS
-	      unix = false;
-#elif defined(Q_OS_UNIX)
-	      unix = true;
-#endif
-	      continue;
-	    }
-	  else if(line.startsWith('#'))
-	    continue;
-
-	  if(general)
-	    {
-	      auto const list(line.split('='));
-	      auto const p
-		(qMakePair(list.value(0).trimmed(), list.value(1).trimmed()));
-
-	      if(p.first.isEmpty() || p.second.isEmpty())
-		continue;
-
-	      if(p.first == "file")
-		{
-#if defined(Q_OS2) || defined(Q_OS_WINDOWS)
-#else
-		  if(p.second.toLower().endsWith(".dll"))
-		    continue;
-#endif
-
-		  FileInformation file_information;
-
-		  file_information.m_executable = false;
-		  files[p.second] = file_information;
-		}
-	      else if(p.first == "file_destination")
-		file_destination = p.second;
-	      else if(p.first == "url")
-		{
-		  /*
-		  ** Begin the download(s).
-		  */
-
-		  if(file_destination.isEmpty())
-		    {
-		      QHashIterator<QString, qup_page::FileInformation> it
-			(files);
-
-		      while(it.hasNext())
-			{
-			  it.next();
-
-			  QHash<QString, qup_page::FileInformation> f;
-
-			  f[it.key()] = it.value();
-			  download_files
-			    (f,
-			     QFileInfo(it.key()).path(),     // Directory
-			     QFileInfo(it.key()).fileName(), // File
-			     string_as_url(p.second));
-			}
-		    }
-		  else
-		    download_files
-		      (files,
-		       file_destination, // Directory
-		       "",
-		       string_as_url(p.second));
-
-		  file_destination.clear();
-		  files.clear();
-		  general = false;
-		}
-	    }
-	  else if(unix)
-	    {
-	      auto const list(line.split('='));
-	      auto const p
-		(qMakePair(list.value(0).trimmed(), list.value(1).trimmed()));
-
-	      if(p.first.isEmpty() || p.second.isEmpty())
-		continue;
-
-	      if(p.first == "desktop" || p.first == "file")
-		{
-		  FileInformation file_information;
-
-		  file_information.m_destination = p.second;
-		  file_information.m_executable = false;
-		  files[p.second] = file_information;
-		}
-	      else if(p.first == "executable" &&
-		      p.second.toLower().endsWith(executable_suffix()))
-		{
-		  FileInformation file_information;
-
-		  file_information.m_destination = "";
-		  file_information.m_executable = true;
-		  files[p.second] = file_information;
-		}
-	      else if(p.first == "local_executable")
-		file_destination = p.second;
-	      else if(p.first == "shell")
-		{
-		  FileInformation file_information;
-
-		  file_information.m_destination = p.second;
-		  file_information.m_executable = true;
-		  files[p.second] = file_information;
-		}
-	      else if(p.first == "url")
-		{
-		  /*
-		  ** Begin the download(s).
-		  */
-
-		  download_files
-		    (files,
-		     "", // Directory
-		     file_destination,
-		     string_as_url(p.second));
-		  file_destination.clear();
-		  files.clear();
-		  unix = false;
-		}
-	    }
-	}
-    }
-  else
-    {
-      append(tr("Cannot open %1 for processing.").arg(m_qup_txt_file_name));
-      return;
-    }
-}
-
 void qup_page::slot_populate_favorite(void)
 {
   auto action = qobject_cast<QAction *> (sender());
@@ -1187,219 +908,145 @@ void qup_page::slot_populate_favorite(void)
   if(!action)
     return;
 
-  QSettings settings;
+  auto const values(m_favorites->values(action->text()));
 
-  settings.beginGroup(QString("favorite-%1").arg(action->text()));
-  m_destination = settings.value("local-directory").toString().trimmed();
-  m_install_automatically = settings.value
+  m_destination = values.value("local-directory").toString().trimmed();
+  m_durability = qup_installer::string_as_durability
+    (values.value("durability").toString());
+  m_install_automatically = values.value
     ("install-automatically", false).toBool();
-  m_path = QDir::tempPath();
-  m_path.append(QDir::separator());
-  m_path.append("qup-");
-  m_path.append(settings.value("name").toString().trimmed());
-  m_path = proper_path(m_path);
+  m_install_mode = qup_installer::string_as_mode
+    (values.value("install-mode").toString());
+  m_install_pipelined = values.value("install-pipelined", false).toBool();
+  m_keep_staged_files = values.value("keep-staged-files", true).toBool();
+  m_path = qup_staging::path
+    (values.value("name").toString(),
+     m_destination,
+     values.value("staging-directory").toString());
+  m_activity_model->set_journal_name(action->text().trimmed());
   m_product = action->text().trimmed();
   m_super_hash.clear();
-  m_tabs_menu_action->setText(settings.value("name").toString().trimmed());
+  m_tabs_menu_action->setText(values.value("name").toString().trimmed());
   m_ui.download_frequency->setCurrentIndex
     (m_ui.download_frequency->
-     findText(settings.value("download-frequency").toString()));
-  m_ui.download_frequency->setCurrentIndex
-    (m_ui.download_frequency->currentIndex() < 0 ?
-     m_ui.download_frequency->findText(tr("Never")) :
-     m_ui.download_frequency->currentIndex());
-  m_ui.favorite_name->setText(settings.value("name").toString().trimmed());
-  m_ui.files->setRowCount(0);
+     findText(values.value("download-frequency").toString()));
+
+  if(m_ui.download_frequency->currentIndex() < 0)
+    {
+      auto const frequency
+	(values.value("download-frequency").toString().trimmed());
+
+      m_ui.download_frequency->setEditText
+	(frequency.isEmpty() ? tr("Never") : frequency);
+    }
+
+  m_ui.favorite_name->setText(values.value("name").toString().trimmed());
+  m_populate_files_table_future.cancel();
+  m_populate_files_table_future.waitForFinished();
+  m_files_model->clear();
   m_ui.files->sortByColumn(0, Qt::AscendingOrder);
+  m_ui.durability->setCurrentIndex(static_cast<int> (m_durability));
   m_ui.install_automatically->setChecked(m_install_automatically);
+  m_ui.install_mode->setCurrentIndex
+    (m_install_mode == qup_installer::Modes::Swap ? 1 : 0);
+  m_ui.install_pipelined->setChecked(m_install_pipelined);
+  m_ui.keep_staged_files->setChecked(m_keep_staged_files);
   m_ui.local_directory->setText
-    (settings.value("local-directory").toString().trimmed());
+    (values.value("local-directory").toString().trimmed());
   m_ui.operating_system->setCurrentIndex
     (m_ui.operating_system->
-     findText(settings.value("operating-system").toString().trimmed()));
+     findText(values.value("operating-system").toString().trimmed()));
   m_ui.operating_system->setCurrentIndex
     (qBound(0,
 	    m_ui.operating_system->currentIndex(),
 	    m_ui.operating_system->count() - 1));
   m_ui.qup_txt_location->setText
-    (string_as_url(settings.value("url").toString().trimmed()).toString());
+    (qup_updater::string_as_url(values.value("url").toString()).
+     toString());
+  m_ui.staging_directory->setText
+    (values.value("staging-directory").toString().trimmed());
+  m_ui.staging_quota->setValue(values.value("staging-quota").toInt());
   launch_file_gatherer();
-  settings.value("download-frequency").toString() != tr("Never") ?
-    m_download_timer.start() : m_download_timer.stop();
   emit product_name_changed(m_ui.favorite_name->text());
 }
 
-void qup_page::slot_populate_favorites(void)
+void qup_page::slot_populate_files_table
+(const quint64 generation, const QVector<qup_file> &data)
 {
-  QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-
-  QMap<QString, char> groups;
-  QSettings settings;
-
-  foreach(auto const &group, settings.childGroups())
-    {
-      settings.beginGroup(group);
-      groups[settings.value("name").toString().trimmed()] = 0;
-      settings.endGroup();
-    }
-
-  m_ui.favorites->menu()->clear();
+  if(generation != m_files_generation)
+    return;
 
-  foreach(auto const &key, groups.keys())
-    if(!key.isEmpty())
-      m_ui.favorites->menu()->addAction
-	(key, this, &qup_page::slot_populate_favorite);
+  qup_trace::Span span("gui", "Merge files");
 
-  m_ui.favorites->setEnabled(!groups.isEmpty());
-  QApplication::restoreOverrideCursor();
+  m_files_model->merge(data);
+  m_ui.files_statistics->setText
+    (tr("%1 file(s) gathered.").
+     arg(QLocale().toString(m_files_model->seen())));
 }
 
-void qup_page::slot_populate_files_table
-(const QByteArray &hash, const QVector<QVector<QString> > &data)
+void qup_page::slot_files_counts_changed(void)
 {
-  m_super_hash = hash;
-
-  auto const h = m_ui.files->horizontalScrollBar()->value();
-  auto const v = m_ui.files->verticalScrollBar()->value();
-  auto const selected_file_name
-    (m_ui.files->selectionModel()->
-     selectedRows(static_cast<int> (FilesColumns::LocalFileName)).
-     value(0).data().toString());
-
-  m_ui.files->setRowCount(data.size());
-  m_ui.files->setSortingEnabled(false);
-
-  for(int i = 0; i < data.size(); i++)
-    {
-      QString tool_tip("<html>");
-      QTableWidgetItem *item_digest_1 = nullptr;
-      QTableWidgetItem *item_digest_2 = nullptr;
-      auto const file(data.at(i));
-
-      for(int j = 0; j < m_ui.files->columnCount(); j++)
-	{
-	  auto item = new QTableWidgetItem(file.value(j));
-
-	  item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-	  m_ui.files->setItem(i, j, item);
-
-	  if(item->text() == selected_file_name &&
-	     j == static_cast<int> (FilesColumns::LocalFileName))
-	    m_ui.files->selectRow(i);
-
-	  if(j == static_cast<int> (FilesColumns::LocalFileDigest))
-	    item_digest_1 = item;
-
-	  if(j == static_cast<int> (FilesColumns::LocalFilePermissions) ||
-	     j == static_cast<int> (FilesColumns::TemporaryFilePermissions))
-	    {
-	      QFont font("Courier");
-
-	      item->setFont(font);
-	    }
-
-	  if(j == static_cast<int> (FilesColumns::TemporaryFileDigest))
-	    item_digest_2 = item;
-
-	  if(item_digest_1 &&
-	     item_digest_2 &&
-	     item_digest_1->text() != item_digest_2->text())
-	    {
-	      item_digest_1->setBackground(qup::INVALID_PROCESS_COLOR);
-	      item_digest_1->setForeground
-		(qup::INVALID_PROCESS_COLOR.lighter());
-	      item_digest_2->setBackground(item_digest_1->background());
-	      item_digest_2->setForeground(item_digest_1->foreground());
-	    }
-
-	  tool_tip.append
-	    (QString("<b>%1:</b> %2").
-	     arg(m_ui.files->horizontalHeaderItem(j)->text()).
-	     arg(item->text()));
-	  tool_tip.append(j < m_ui.files->columnCount() - 1 ? "<br>" : "");
-	}
-
-      tool_tip.append("</html>");
-
-      for(int j = 0; j < m_ui.files->columnCount(); j++)
-	if(m_ui.files->item(i, j))
-	  m_ui.files->item(i, j)->setToolTip(tool_tip);
-    }
-
-  m_ui.files->horizontalScrollBar()->setValue(h);
-  m_ui.files->resizeColumnsToContents();
-  m_ui.files->setSortingEnabled(true);
-  m_ui.files->sortByColumn
-    (m_ui.files->horizontalHeader()->sortIndicatorSection(),
-     m_ui.files->horizontalHeader()->sortIndicatorOrder());
-  m_ui.files->verticalScrollBar()->setValue(v);
+  QList<QPair<qup_files_model::Filters, QString> > list;
+
+  list << qMakePair(qup_files_model::Filters::All, tr("All"))
+       << qMakePair(qup_files_model::Filters::Mismatched,
+		    tr("Different Digests"))
+       << qMakePair(qup_files_model::Filters::Missing, tr("Missing"))
+       << qMakePair(qup_files_model::Filters::Permissions,
+		    tr("Different Permissions"));
+
+  for(int i = 0; i < list.size(); i++)
+    m_ui.files_filter->setItemText
+      (static_cast<int> (list.at(i).first),
+       QString("%1 (%2)").
+       arg(list.at(i).second).
+       arg(QLocale().toString(m_files_model->count(list.at(i).first))));
 }
 
-void qup_page::slot_refresh(void)
+void qup_page::slot_files_filter(int index)
 {
-  m_super_hash.clear();
-  launch_file_gatherer();
+  m_files_model->set_filter
+    (static_cast<qup_files_model::Filters>
+     (qBound(static_cast<int> (qup_files_model::Filters::All),
+	     index,
+	     static_cast<int> (qup_files_model::Filters::Permissions))));
 }
 
-void qup_page::slot_reply_finished(void)
+void qup_page::slot_files_gathered
+(const quint64 generation, const QByteArray &hash, const bool complete)
 {
-  auto reply = qobject_cast<QNetworkReply *> (sender());
-
-  if(!reply)
-    {
-      append(tr("<font color='darkred'>Cannot discover QNetworkReply object. "
-		"Serious problem!</font>"));
-      return;
-    }
+  if(generation != m_files_generation)
+    return;
 
-  if(reply->error() != QNetworkReply::NoError)
-    {
-      auto property
-	(reply->property(PropertyNames::AbsoluteFilePath).toString());
+  qup_trace::Span span("gui", "Files gathered");
 
-      if(!property.isEmpty())
-	QFile::remove(property);
+  /*
+  ** An unchanged gather does not deliver its files.
+  */
 
-      append
-	(tr("<font color='darkred'>An error occurred while downloading %1."
-	    "</font>").
-	 arg(reply->property(PropertyNames::FileName).toString()));
-      m_ok = false;
-    }
+  if(complete && hash == m_super_hash)
+    m_files_model->end_merge(false);
   else
     {
-      append
-	(tr("<font color='darkgreen'>Completed downloading %1.</font>").
-	 arg(reply->property(PropertyNames::FileName).toString()));
+      m_files_model->end_merge(complete);
 
-      if(reply->property(PropertyNames::Executable).toBool())
+      if(complete)
 	{
-	  QFile file
-	    (reply->property(PropertyNames::AbsoluteFilePath).toString());
-
-	  file.setPermissions(QFileDevice::ExeOwner | file.permissions());
+	  m_ui.files->resizeColumnsToContents();
+	  m_super_hash = hash;
 	}
     }
 
-  reply->deleteLater();
-
-  if(m_ok)
-    /*
-    ** Downloads completed!
-    */
+  m_ui.files_progress->setVisible(false);
+  m_ui.files_statistics->setText
+    (tr("%1 file(s).").arg(QLocale().toString(m_files_model->rowCount())));
+  populate_metrics();
+}
 
-    m_copy_files_timer.start();
-  else
-    {
-      if(m_network_access_manager.
-	 findChildren<QNetworkReply *> ().size() - 1 <= 0)
-	{
-	  append
-	    (tr("<font color='darkred'>Some of the files were not downloaded. "
-		"Please review.</font>"));
-	  m_install_automatically ? m_ui.install->click() : (void) 0;
-	}
-    }
+void qup_page::slot_refresh(void)
+{
+  m_super_hash.clear();
+  launch_file_gatherer();
 }
 
 void qup_page::slot_save_favorite(void)
@@ -1407,7 +1054,8 @@ void qup_page::slot_save_favorite(void)
   auto const local_directory
     (QDir::cleanPath(m_ui.local_directory->text().trimmed()));
   auto const name(m_ui.favorite_name->text().trimmed());
-  auto const url(string_as_url(m_ui.qup_txt_location->text().trimmed()));
+  auto const url
+    (qup_updater::string_as_url(m_ui.qup_txt_location->text().trimmed()));
 
   if(local_directory.trimmed().isEmpty() ||
      name.isEmpty() ||
@@ -1421,37 +1069,51 @@ void qup_page::slot_save_favorite(void)
   else
     m_ui.qup_txt_location->setText(url.toString());
 
-  QSettings settings;
-
-  settings.beginGroup(QString("favorite-%1").arg(name));
-  settings.setValue
-    ("download-frequency", m_ui.download_frequency->currentText());
-  settings.setValue
-    ("install-automatically", m_ui.install_automatically->isChecked());
-  settings.setValue("local-directory", local_directory);
-  settings.setValue("name", name);
-  settings.setValue("operating-system", m_ui.operating_system->currentText());
-  settings.setValue("url", url.toString());
-  settings.endGroup();
+  if(!qup_scheduler::valid(m_ui.download_frequency->currentText()))
+    {
+      append(tr("<font color='darkred'>The download frequency %1 is not "
+		"understood.</font>").
+	     arg(m_ui.download_frequency->currentText()));
+      return;
+    }
 
-  if(settings.status() == QSettings::NoError)
+  QVariantMap values;
+
+  values["download-frequency"] = m_ui.download_frequency->currentText();
+  values["durability"] = qup_installer::durability_as_string
+    (static_cast<qup_installer::Durabilities>
+     (m_ui.durability->currentIndex()));
+  values["install-automatically"] = m_ui.install_automatically->isChecked();
+  values["install-mode"] = qup_installer::mode_as_string
+    (m_ui.install_mode->currentIndex() == 1 ?
+     qup_installer::Modes::Swap : qup_installer::Modes::InPlace);
+  values["install-pipelined"] = m_ui.install_pipelined->isChecked();
+  values["keep-staged-files"] = m_ui.keep_staged_files->isChecked();
+  values["local-directory"] = local_directory;
+  values["name"] = name;
+  values["operating-system"] = m_ui.operating_system->currentText();
+  values["staging-directory"] = m_ui.staging_directory->text().trimmed();
+  values["staging-quota"] = m_ui.staging_quota->value();
+  values["url"] = url.toString();
+
+  if(m_favorites->save(name, values))
     {
-      QTimer::singleShot(s_populate_favorites_interval,
-			 this,
-			 &qup_page::slot_populate_favorites);
       append
 	(tr("<font color='darkgreen'>The favorite %1 has been saved "
 	    "in the Qup INI file.</font>").arg(name));
       m_destination = local_directory;
+      m_durability = static_cast<qup_installer::Durabilities>
+	(m_ui.durability->currentIndex());
       m_install_automatically = m_ui.install_automatically->isChecked();
+      m_install_mode = m_ui.install_mode->currentIndex() == 1 ?
+	qup_installer::Modes::Swap : qup_installer::Modes::InPlace;
+      m_install_pipelined = m_ui.install_pipelined->isChecked();
+      m_keep_staged_files = m_ui.keep_staged_files->isChecked();
+      m_activity_model->set_journal_name(name);
       m_product = name;
       m_super_hash.clear();
       m_tabs_menu_action->setText(name);
-      m_ui.download_frequency->currentIndex() !=
-	m_ui.download_frequency->findText(tr("Never")) ?
-	m_download_timer.start() : m_download_timer.stop();
       m_ui.local_directory->setText(local_directory);
-      emit populate_favorites();
       emit product_name_changed(m_ui.favorite_name->text());
     }
   else
@@ -1479,6 +1141,25 @@ void qup_page::slot_select_local_directory(void)
     QApplication::processEvents();
 }
 
+void qup_page::slot_select_staging_directory(void)
+{
+  QFileDialog dialog(this);
+
+  dialog.setDirectory(QDir::homePath());
+  dialog.setFileMode(QFileDialog::Directory);
+  dialog.setLabelText(QFileDialog::Accept, tr("Select"));
+  dialog.setWindowTitle(tr("Qup: Select Staging Directory"));
+  dialog.selectFile(m_ui.staging_directory->text());
+
+  if(dialog.exec() == QDialog::Accepted)
+    {
+      QApplication::processEvents();
+      m_ui.staging_directory->setText(dialog.selectedFiles().value(0));
+    }
+  else
+    QApplication::processEvents();
+}
+
 void qup_page::slot_settings_applied(void)
 {
   slot_refresh();
@@ -1486,6 +1167,7 @@ void qup_page::slot_settings_applied(void)
 
 void qup_page::slot_timeout(void)
 {
+  qup_trace::Span span("gui", "Poll");
   QColor color(qup::INVALID_PROCESS_COLOR);
   auto palette(m_ui.local_directory->palette());
 
@@ -1499,106 +1181,17 @@ void qup_page::slot_timeout(void)
 
   palette.setColor(m_ui.local_directory->backgroundRole(), color);
   m_ui.local_directory->setPalette(palette);
+  m_updater->active() ? populate_metrics() : (void) 0;
 }
 
-void qup_page::slot_write_file(void)
-{
-  auto reply = qobject_cast<QNetworkReply *> (sender());
-
-  if(!reply)
-    return;
-
-  if(!reply->property(PropertyNames::DestinationDirectory).toString().isEmpty())
-    QDir().mkpath
-      (m_path +
-       QDir::separator() +
-       reply->property(PropertyNames::DestinationDirectory).toString());
-
-  QFile file;
-
-  if(!reply->property(PropertyNames::DestinationDirectory).toString().isEmpty())
-    file.setFileName
-      (m_path +
-       QDir::separator() +
-       reply->property(PropertyNames::DestinationDirectory).toString() +
-       QDir::separator() +
-       reply->property(PropertyNames::FileName).toString());
-  else
-    file.setFileName
-      (m_path +
-       QDir::separator() +
-       reply->property(PropertyNames::DestinationFile).toString());
-
-  QIODevice::OpenMode flags = QIODevice::NotOpen;
-
-  if(reply->property(PropertyNames::Read).toBool())
-    flags = QIODevice::Append | QIODevice::WriteOnly;
-  else
-    flags = QIODevice::Truncate | QIODevice::WriteOnly;
-
-  reply->setProperty(PropertyNames::AbsoluteFilePath, file.fileName());
-  reply->setProperty(PropertyNames::Read, true);
-
-  if(file.open(flags) && reply->bytesAvailable() > 0)
-    while(reply->bytesAvailable() > 0)
-      file.write(reply->readAll());
-}
-
-void qup_page::slot_write_instruction_file_data(void)
+void qup_page::slot_update_finished(const bool ok)
 {
-  if(!m_instruction_file_reply)
-    return;
-
-  while(m_instruction_file_reply->bytesAvailable() > 0)
-    {
-      m_instruction_file_reply_data.append
-	(m_instruction_file_reply->readAll());
-
-      if(m_instruction_file_reply_data.size() >
-	 s_maximum_size_of_instruction_buffer)
-	break;
-
-      if(m_instruction_file_reply_data.trimmed().endsWith(s_end_of_file))
-	break;
-    }
+  populate_metrics();
 
-  if(m_instruction_file_reply_data.trimmed().endsWith(s_end_of_file))
-    {
-      QFile file(m_qup_txt_file_name);
-      QFileInfo const file_information(m_qup_txt_file_name);
-
-      if(file.open(QIODevice::Text |
-		   QIODevice::Truncate |
-		   QIODevice::WriteOnly))
-	{
-	  if(file.write(m_instruction_file_reply_data) ==
-	     static_cast<qint64> (m_instruction_file_reply_data.length()))
-	    {
-	      QTimer::singleShot
-		(1000, this, &qup_page::slot_parse_instruction_file);
-	      append
-		(tr("<font color='darkgreen'>File %1 saved locally.</font>").
-		 arg(file_information.fileName()));
-	    }
-	  else
-	    append
-	      (tr("<font color='darkred'>Could not write the entire file %1."
-		  "</font>").arg(file_information.fileName()));
-
-	  launch_file_gatherer();
-	}
-      else
-	append
-	  (tr("<font color='darkred'>Could not open a local file %1.</file>").
-	   arg(file_information.fileName()));
+  if(ok && !m_install_automatically)
+    append
+      (tr("<font color='darkgreen'>You may now install %1!</font>").
+       arg(m_product));
 
-      m_instruction_file_reply->abort();
-      m_instruction_file_reply_data.clear();
-    }
-  else if(m_instruction_file_reply_data.size() >
-	  s_maximum_size_of_instruction_buffer)
-    {
-      m_instruction_file_reply->abort();
-      m_instruction_file_reply_data.clear();
-    }
+  launch_file_gatherer();
 }
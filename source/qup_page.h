@@ -31,116 +31,107 @@
 #include <QFileDevice>
 #include <QFuture>
 #include <QFutureWatcher>
-#include <QNetworkAccessManager>
-#include <QPointer>
 #include <QTimer>
 
+#include "qup_activity_model.h"
+#include "qup_files_model.h"
+#include "qup_installer.h"
+#include "qup_journal.h"
+#include "qup_updater.h"
 #include "ui_qup_page.h"
 
+class qup_favorites;
+
 class qup_page: public QWidget
 {
   Q_OBJECT
 
  public:
-  qup_page(QWidget *parent);
+  qup_page(qup_favorites *favorites,
+	   qup_journal *journal,
+	   QWidget *parent);
   ~qup_page();
   QAction *tabs_menu_action(void) const;
+  QString product(void) const;
   bool active(void) const;
+  void download(void);
   void interrupt(void);
 
  public slots:
-  void slot_populate_favorites(void);
   void slot_settings_applied(void);
 
  private:
-  class FileInformation
-  {
-  public:
-    QString m_destination;
-    bool m_executable;
-  };
-
-  enum class FilesColumns
-  {
-    LocalFileDigest = 2,
-    LocalFileName = 0,
-    LocalFilePermissions = 1,
-    TemporaryFileDigest = 5,
-    TemporaryFileName = 3,
-    TemporaryFilePermissions = 4,
-    XYZ = TemporaryFileDigest + 1
-  };
-
   QAction *m_tabs_menu_action;
-  QByteArray m_instruction_file_reply_data;
   QByteArray m_super_hash;
   QFuture<void> m_copy_files_future;
   QFuture<void> m_populate_files_table_future;
   QFutureWatcher<void> m_copy_files_future_watcher;
-  QNetworkAccessManager m_network_access_manager;
-  QPointer<QNetworkReply> m_instruction_file_reply;
   QString m_destination;
-  QString m_operating_system;
   QString m_path;
   QString m_product;
-  QString m_qup_txt_file_name;
-  QTimer m_copy_files_timer;
-  QTimer m_download_timer;
+  qup_activity_model *m_activity_model;
+  qup_favorites *m_favorites;
+  qup_files_model *m_files_model;
+  qup_installer::Durabilities m_durability;
+  qup_installer::Modes m_install_mode;
+  qup_updater *m_updater;
   QTimer m_timer;
   Ui_qup_page m_ui;
   bool m_install_automatically;
-  bool m_ok;
-  QString executable_suffix(void) const;
-  static QUrl string_as_url(const QString &s);
-  static QString permissions_as_string
-    (const QFileDevice::Permissions permissions);
+  bool m_install_pipelined;
+  bool m_keep_staged_files;
+  bool m_prepared;
+  quint64 m_files_generation;
   static QString proper_path(const QString &path);
   void closeEvent(QCloseEvent *event);
   void copy_files
     (const QString &destination_path,
      const QString &local_path,
-     const QString &product);
-  void download_files
-    (const QHash<QString, FileInformation> &files,
-     const QString &directory_destination,
-     const QString &file_destination,
-     const QUrl &url);
+     const QString &product,
+     const qup_installer::Modes mode,
+     const qup_installer::Durabilities durability,
+     const bool keep_staged_files);
   void gather_files
-    (const QByteArray &super_hash,
+    (const quint64 generation,
+     const QByteArray &super_hash,
      const QString &destination_path,
      const QString &local_path);
+  void populate_favorites(void);
+  void populate_metrics(void);
   void prepare_operating_systems_widget(void);
-  void prepare_shell_file
-    (const QString &destination_path,
-     const QString &path,
-     const QString &product);
+  void prepare_widgets(void);
+  void showEvent(QShowEvent *event);
 
  private slots:
   void append(const QString &text);
   void launch_file_gatherer(void);
-  void slot_copy_files(void);
+  void slot_activity_inserted(void);
   void slot_delete_favorite(void);
   void slot_download(void);
+  void slot_export_metrics(void);
+  void slot_favorite_added(const QString &name);
+  void slot_favorite_removed(const QString &name);
   void slot_install(void);
-  void slot_instruction_reply_finished(void);
   void slot_launch(void);
-  void slot_parse_instruction_file(void);
   void slot_populate_favorite(void);
+  void slot_files_counts_changed(void);
+  void slot_files_filter(int index);
+  void slot_files_gathered
+    (const quint64 generation, const QByteArray &hash, const bool complete);
   void slot_populate_files_table
-    (const QByteArray &hash, const QVector<QVector<QString> > &data);
+    (const quint64 generation, const QVector<qup_file> &data);
   void slot_refresh(void);
-  void slot_reply_finished(void);
   void slot_save_favorite(void);
   void slot_select_local_directory(void);
+  void slot_select_staging_directory(void);
   void slot_timeout(void);
-  void slot_write_file(void);
-  void slot_write_instruction_file_data(void);
+  void slot_update_finished(const bool ok);
 
  signals:
-  void append_text(const QString &text);
   void files_gathered
-    (const QByteArray &hash, const QVector<QVector<QString> > &data);
-  void populate_favorites(void);
+    (const quint64 generation, const QByteArray &hash, const bool complete);
+  void files_gathered_batch
+    (const quint64 generation, const QVector<qup_file> &data);
   void product_name_changed(const QString &text);
 };
 
@@ -0,0 +1,324 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QSettings>
+
+#include "qup_favorites.h"
+#include "qup_scheduler.h"
+#include "qup_updater.h"
+
+const int static s_slots = 3600; // One hour of one-second slots.
+
+qup_scheduler::qup_scheduler(qup_favorites *favorites, QObject *parent):
+  QObject(parent)
+{
+  QSettings settings;
+  auto ok = false;
+
+  m_favorites = favorites;
+  m_seed = settings.value("scheduler-seed").toString().toULongLong(&ok);
+
+  if(!ok || m_seed == 0)
+    {
+      /*
+      ** The seed distinguishes this computer from others.
+      */
+
+      m_seed = QRandomGenerator::system()->generate64();
+      settings.setValue("scheduler-seed", QString::number(m_seed));
+    }
+
+  m_tick = QDateTime::currentSecsSinceEpoch();
+  m_timer.setTimerType(Qt::CoarseTimer);
+  m_wheel.resize(s_slots);
+  connect(&m_timer,
+	  &QTimer::timeout,
+	  this,
+	  &qup_scheduler::slot_tick);
+  connect(m_favorites,
+	  &qup_favorites::added,
+	  this,
+	  &qup_scheduler::slot_reload);
+  connect(m_favorites,
+	  &qup_favorites::changed,
+	  this,
+	  &qup_scheduler::slot_reload);
+  connect(m_favorites,
+	  &qup_favorites::removed,
+	  this,
+	  &qup_scheduler::slot_reload);
+  slot_reload();
+  m_timer.start(1000);
+}
+
+qup_scheduler::~qup_scheduler()
+{
+  m_timer.stop();
+}
+
+bool qup_scheduler::valid(const QString &text)
+{
+  return Schedule::parse(text).m_valid;
+}
+
+qint64 qup_scheduler::next(const Entry &entry, const qint64 after) const
+{
+  /*
+  ** The earliest aligned occurrence after the provided time which
+  ** also satisfies the window.
+  */
+
+  auto const interval = entry.m_schedule.m_interval;
+  auto const offset = static_cast<qint64> (splay(entry.m_host, interval));
+  auto const due = ((after - offset) / interval + 1) * interval + offset;
+
+  if(entry.m_schedule.m_days == 0 && entry.m_schedule.m_window_begin < 0)
+    return due;
+
+  auto const date(QDateTime::fromSecsSinceEpoch(due).date());
+
+  for(int i = -1; i <= 8; i++)
+    {
+      auto const day(date.addDays(i));
+
+      if(entry.m_schedule.m_days != 0 &&
+	 !(entry.m_schedule.m_days & (1 << day.dayOfWeek())))
+	continue;
+
+      qint64 end = 0;
+      qint64 start = 0;
+
+      if(entry.m_schedule.m_window_begin >= 0)
+	{
+	  auto const begin = entry.m_schedule.m_window_begin;
+	  auto const finish = entry.m_schedule.m_window_end;
+
+	  end = QDateTime
+	    (finish > begin ? day : day.addDays(1),
+	     QTime(finish / 60, finish % 60)).toSecsSinceEpoch();
+	  start = QDateTime
+	    (day, QTime(begin / 60, begin % 60)).toSecsSinceEpoch();
+	}
+      else
+	{
+	  end = QDateTime(day.addDays(1), QTime(0, 0)).toSecsSinceEpoch();
+	  start = QDateTime(day, QTime(0, 0)).toSecsSinceEpoch();
+	}
+
+      if(due >= end || end <= after)
+	continue;
+      else if(due >= start)
+	return due;
+      else
+	return start + static_cast<qint64> (splay(entry.m_host, end - start));
+    }
+
+  return due;
+}
+
+qup_scheduler::Schedule qup_scheduler::Schedule::parse(const QString &text)
+{
+  Schedule schedule;
+  auto const t(text.simplified().toLower());
+
+  if(t.isEmpty() || t == "never" || t == qup_scheduler::tr("Never").toLower())
+    {
+      schedule.m_valid = true;
+      return schedule;
+    }
+
+  static QRegularExpression const r
+    ("^(?:(hourly|daily|weekly)|every\\s+(\\d+)\\s*(minutes?|hours?|days?))"
+     "(?:\\s+between\\s+(\\d{1,2}):(\\d{2})\\s+and\\s+(\\d{1,2}):(\\d{2}))?"
+     "(?:\\s+on\\s+([a-z]{3}(?:\\s*,\\s*[a-z]{3})*))?$");
+  auto const match(r.match(t));
+
+  if(!match.hasMatch())
+    return schedule;
+
+  if(match.captured(1) == "hourly")
+    schedule.m_interval = 3600;
+  else if(match.captured(1) == "daily")
+    schedule.m_interval = 86400;
+  else if(match.captured(1) == "weekly")
+    schedule.m_interval = 604800;
+  else
+    {
+      auto const unit(match.captured(3));
+
+      schedule.m_interval = match.captured(2).toLongLong();
+
+      if(unit.startsWith("minute"))
+	schedule.m_interval *= 60;
+      else if(unit.startsWith("hour"))
+	schedule.m_interval *= 3600;
+      else
+	schedule.m_interval *= 86400;
+    }
+
+  if(schedule.m_interval <= 0)
+    return schedule;
+
+  if(!match.captured(4).isEmpty())
+    {
+      auto const begin_hour = match.captured(4).toInt();
+      auto const begin_minute = match.captured(5).toInt();
+      auto const end_hour = match.captured(6).toInt();
+      auto const end_minute = match.captured(7).toInt();
+
+      if(begin_hour > 23 ||
+	 begin_minute > 59 ||
+	 end_hour > 23 ||
+	 end_minute > 59)
+	return schedule;
+
+      schedule.m_window_begin = 60 * begin_hour + begin_minute;
+      schedule.m_window_end = 60 * end_hour + end_minute;
+
+      if(schedule.m_window_begin == schedule.m_window_end)
+	return schedule;
+    }
+
+  if(!match.captured(8).isEmpty())
+    {
+      QStringList const days
+	{"mon", "tue", "wed", "thu", "fri", "sat", "sun"};
+
+      foreach(auto const &day, match.captured(8).split(','))
+	{
+	  auto const index = days.indexOf(day.trimmed());
+
+	  if(index < 0)
+	    return schedule;
+
+	  schedule.m_days |= static_cast<quint8> (1 << (index + 1));
+	}
+    }
+
+  schedule.m_valid = true;
+  return schedule;
+}
+
+quint64 qup_scheduler::splay(const QString &host, const qint64 range) const
+{
+  if(range <= 0)
+    return 0;
+
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  quint64 value = 0;
+
+  hash.addData(QByteArray::number(m_seed));
+  hash.addData(host.toLower().toUtf8());
+
+  auto const result(hash.result());
+
+  for(int i = 0; i < 8; i++)
+    value = (value << 8) | static_cast<quint8> (result.at(i));
+
+  return value % static_cast<quint64> (range);
+}
+
+void qup_scheduler::insert(const Entry &entry)
+{
+  m_wheel[static_cast<int> (entry.m_due % s_slots)] << entry;
+}
+
+void qup_scheduler::slot_reload(void)
+{
+  auto const now = QDateTime::currentSecsSinceEpoch();
+
+  for(int i = 0; i < m_wheel.size(); i++)
+    m_wheel[i].clear();
+
+  foreach(auto const &name, m_favorites->names())
+    {
+      Entry entry;
+      auto const values(m_favorites->values(name));
+
+      entry.m_schedule = Schedule::parse
+	(values.value("download-frequency").toString());
+
+      if(!entry.m_schedule.m_valid || entry.m_schedule.never())
+	continue;
+
+      entry.m_host = qup_updater::string_as_url
+	(values.value("url").toString()).host();
+      entry.m_name = name;
+      entry.m_due = next(entry, now);
+      insert(entry);
+    }
+}
+
+void qup_scheduler::slot_tick(void)
+{
+  /*
+  ** A single timer visits the slots which have elapsed since the
+  ** previous tick. A long interval implies that the computer slept;
+  ** every slot is then visited.
+  */
+
+  auto const now = QDateTime::currentSecsSinceEpoch();
+
+  if(now <= m_tick)
+    {
+      m_tick = now;
+      return;
+    }
+
+  if(now - m_tick >= s_slots)
+    for(int i = 0; i < s_slots; i++)
+      visit(i, now);
+  else
+    for(auto t = m_tick + 1; t <= now; t++)
+      visit(t % s_slots, now);
+
+  m_tick = now;
+}
+
+void qup_scheduler::visit(const qint64 slot, const qint64 now)
+{
+  auto &entries(m_wheel[static_cast<int> (slot)]);
+  QVector<Entry> ready;
+
+  for(int i = entries.size() - 1; i >= 0; i--)
+    if(entries.at(i).m_due <= now)
+      {
+	ready.prepend(entries.at(i));
+	entries.remove(i);
+      }
+
+  foreach(auto entry, ready)
+    {
+      emit due(entry.m_name);
+      entry.m_due = next(entry, now);
+      insert(entry);
+    }
+}
@@ -0,0 +1,111 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_scheduler_h_
+#define _qup_scheduler_h_
+
+#include <QTimer>
+#include <QVector>
+
+class qup_favorites;
+
+/*
+** Schedules every favorite's updates on one timer wheel of one-second
+** slots. A schedule is composed of an interval and an optional window,
+** for example, "Every 6 Hours Between 01:00 And 05:00 On Mon,Thu".
+** Occurrences are aligned to the interval and offset by a stable,
+** pseudo-random splay which is derived from the product's host so that
+** clients do not contact a host at the same moment. Slots which were
+** missed, perhaps because the computer was asleep, are visited late and
+** their favorites are updated once.
+*/
+
+class qup_scheduler: public QObject
+{
+  Q_OBJECT
+
+ public:
+  class Schedule
+  {
+  public:
+    Schedule(void)
+    {
+      m_days = 0;
+      m_interval = 0;
+      m_valid = false;
+      m_window_begin = -1;
+      m_window_end = -1;
+    }
+
+    bool never(void) const
+    {
+      return m_interval <= 0;
+    }
+
+    static Schedule parse(const QString &text);
+    bool m_valid;
+    int m_window_begin; // Minutes since midnight.
+    int m_window_end; // Minutes since midnight.
+    qint64 m_interval; // Seconds.
+    quint8 m_days; // Qt::DayOfWeek bits, zero is every day.
+  };
+
+  qup_scheduler(qup_favorites *favorites, QObject *parent);
+  ~qup_scheduler();
+  static bool valid(const QString &text);
+
+ public slots:
+  void slot_reload(void);
+
+ private:
+  class Entry
+  {
+  public:
+    QString m_host;
+    QString m_name;
+    Schedule m_schedule;
+    qint64 m_due; // Seconds since the epoch.
+  };
+
+  QTimer m_timer;
+  QVector<QVector<Entry> > m_wheel;
+  qint64 m_tick; // Seconds since the epoch.
+  quint64 m_seed;
+  qup_favorites *m_favorites;
+  qint64 next(const Entry &entry, const qint64 after) const;
+  quint64 splay(const QString &host, const qint64 range) const;
+  void insert(const Entry &entry);
+  void visit(const qint64 slot, const qint64 now);
+
+ private slots:
+  void slot_tick(void);
+
+ signals:
+  void due(const QString &name);
+};
+
+#endif
@@ -0,0 +1,165 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSet>
+#include <QSettings>
+
+#include "qup_staging.h"
+
+const int static s_stale_age = 86400; // Seconds.
+
+QString qup_staging::marker(const QString &path)
+{
+  return QFileInfo(path + "/.qup-staging").absoluteFilePath();
+}
+
+QString qup_staging::path(const QString &name,
+			  const QString &destination,
+			  const QString &directory)
+{
+  QString path("");
+
+  if(directory.trimmed().isEmpty())
+    {
+      QFileInfo const file_information
+	(QFileInfo(QDir::cleanPath(destination.trimmed())).absolutePath());
+
+      if(!destination.trimmed().isEmpty() && file_information.isWritable())
+	{
+	  path.append(file_information.absoluteFilePath());
+	  path.append(QDir::separator());
+	  path.append(".qup-");
+	}
+      else
+	{
+	  path.append(QDir::tempPath());
+	  path.append(QDir::separator());
+	  path.append("qup-");
+	}
+    }
+  else
+    {
+      path.append(QDir::cleanPath(directory.trimmed()));
+      path.append(QDir::separator());
+      path.append("qup-");
+    }
+
+  path.append(name.trimmed());
+  return QFileInfo(path).absoluteFilePath();
+}
+
+bool qup_staging::mark(const QString &path)
+{
+  /*
+  ** The marker's modification time is the tree's most recent use.
+  */
+
+  QFile file(marker(path));
+
+  return file.open(QIODevice::Text |
+		   QIODevice::Truncate |
+		   QIODevice::WriteOnly) &&
+    file.write("Qup staging directory.\n") > 0;
+}
+
+bool qup_staging::marked(const QString &path)
+{
+  return QFileInfo(marker(path)).isFile();
+}
+
+qint64 qup_staging::size(const QString &path)
+{
+  /*
+  ** The bytes of the staged files, excluding the marker.
+  */
+
+  QDirIterator it
+    (path, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+  auto const m(marker(path));
+  qint64 bytes = 0;
+
+  while(it.hasNext())
+    {
+      it.next();
+
+      if(it.fileInfo().absoluteFilePath() != m)
+	bytes += it.fileInfo().size();
+    }
+
+  return bytes;
+}
+
+void qup_staging::collect_garbage(void)
+{
+  /*
+  ** Only marked trees are removed. The trees of current favorites
+  ** are retained.
+  */
+
+  QSet<QString> paths;
+  QSet<QString> roots;
+  QSettings settings;
+
+  roots << QFileInfo(QDir::tempPath()).absoluteFilePath();
+
+  foreach(auto const &group, settings.childGroups())
+    if(group.startsWith("favorite-"))
+      {
+	settings.beginGroup(group);
+
+	auto const p
+	  (path(settings.value("name").toString(),
+		settings.value("local-directory").toString(),
+		settings.value("staging-directory").toString()));
+
+	paths << p;
+	roots << QFileInfo(p).absolutePath();
+	settings.endGroup();
+      }
+
+  auto const now(QDateTime::currentDateTime());
+
+  foreach(auto const &root, roots)
+    foreach(auto const &file_information,
+	    QDir(root).entryInfoList(QStringList() << ".qup-*" << "qup-*",
+				     QDir::Dirs |
+				     QDir::Hidden |
+				     QDir::NoDotAndDotDot))
+      {
+	auto const tree(file_information.absoluteFilePath());
+
+	if(paths.contains(tree) || !marked(tree))
+	  continue;
+
+	if(QFileInfo(marker(tree)).lastModified().secsTo(now) > s_stale_age)
+	  QDir(tree).removeRecursively();
+      }
+}
@@ -28,9 +28,11 @@
 #ifndef _swifty_h_
 #define _swifty_h_
 
+#include <QDateTime>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QPointer>
+#include <QSettings>
 
 class swifty: public QNetworkAccessManager
 {
@@ -42,7 +44,9 @@ class swifty: public QNetworkAccessManager
 	 const QUrl &url,
 	 QObject *parent):QNetworkAccessManager(parent)
   {
+    m_cache_ttl = 0;
     m_current_version = m_newest_version = current_version;
+    m_parsed = false;
     m_search_for_string = search_for_string;
     m_url = url;
   }
@@ -59,11 +63,37 @@ class swifty: public QNetworkAccessManager
   void download()
   {
     m_buffer.clear();
+    m_parsed = false;
 
     if(m_reply)
       m_reply->deleteLater();
 
-    m_reply = get(QNetworkRequest(m_url));
+    QNetworkRequest request(m_url);
+
+    if(!m_cache_file_name.isEmpty())
+      {
+	QSettings settings(m_cache_file_name, QSettings::IniFormat);
+	auto const time = settings.value("time").toLongLong();
+	auto const version(settings.value("version").toString());
+
+	if(!version.isEmpty() &&
+	   QDateTime::currentSecsSinceEpoch() - time >= 0 &&
+	   QDateTime::currentSecsSinceEpoch() - time < m_cache_ttl)
+	  {
+	    /*
+	    ** The cached version is fresh.
+	    */
+
+	    compare(version);
+	    return;
+	  }
+
+	if(!version.isEmpty() && settings.contains("etag"))
+	  request.setRawHeader
+	    ("If-None-Match", settings.value("etag").toByteArray());
+      }
+
+    m_reply = get(request);
     connect(m_reply,
 	    SIGNAL(finished(void)),
 	    this,
@@ -74,42 +104,108 @@ class swifty: public QNetworkAccessManager
 	    SLOT(slot_ready_read(void)));
   }
 
+  void set_cache(const QString &file_name, const qint64 ttl)
+  {
+    /*
+    ** The newest version and the ETag of the URL are retained in
+    ** file_name for ttl seconds.
+    */
+
+    m_cache_file_name = file_name;
+    m_cache_ttl = ttl;
+  }
+
  private:
   QByteArray m_buffer;
   QPointer<QNetworkReply> m_reply;
+  QString m_cache_file_name;
   QString m_current_version;
   QString m_newest_version;
   QString m_search_for_string;
   QUrl m_url;
+  bool m_parsed;
+  qint64 m_cache_ttl; // Seconds.
 
- private slots:
-  void slot_finished(void)
+  bool parse(const bool complete)
   {
-    if(m_reply)
-      m_reply->deleteLater();
+    auto const search_for_string(m_search_for_string.toUtf8());
+    auto const index = m_buffer.indexOf(search_for_string);
+
+    if(index < 0)
+      return false;
+
+    auto version = m_buffer.mid(index + search_for_string.length());
+    auto const end = version.indexOf('\n');
 
-    auto const index = m_buffer.indexOf(m_search_for_string.toUtf8());
+    if(end < 0 && !complete)
+      return false;
 
-    if(index >= 0)
+    version = version.mid(0, end).replace('"', "").replace(';', "").
+      trimmed();
+    m_parsed = true;
+
+    if(!m_cache_file_name.isEmpty())
       {
-	auto version = m_buffer.mid
-	  (index + m_search_for_string.toUtf8().length());
+	QSettings settings(m_cache_file_name, QSettings::IniFormat);
 
-	version = version.mid(0, version.indexOf('\n')).replace('"', "").
-	  replace(';', "").trimmed();
+	m_reply && m_reply->hasRawHeader("ETag") ?
+	  settings.setValue("etag", m_reply->rawHeader("ETag")) :
+	  settings.remove("etag");
+	settings.setValue("time", QDateTime::currentSecsSinceEpoch());
+	settings.setValue("version", QString(version));
+      }
 
-	if(m_current_version != version)
-	  {
-	    m_newest_version = version;
-	    emit different(m_newest_version);
-	  }
+    compare(version);
+    return true;
+  }
+
+  void compare(const QString &version)
+  {
+    if(!version.isEmpty() && m_current_version != version)
+      {
+	m_newest_version = version;
+	emit different(m_newest_version);
       }
   }
 
+ private slots:
+  void slot_finished(void)
+  {
+    if(!m_reply)
+      return;
+
+    auto const status = m_reply->attribute
+      (QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    m_reply->deleteLater();
+
+    if(m_parsed || parse(true) || m_cache_file_name.isEmpty())
+      return;
+
+    /*
+    ** The resource has not changed or could not be retrieved.
+    ** The cached version is used.
+    */
+
+    QSettings settings(m_cache_file_name, QSettings::IniFormat);
+
+    if(status == 304)
+      settings.setValue("time", QDateTime::currentSecsSinceEpoch());
+
+    compare(settings.value("version").toString());
+  }
+
   void slot_ready_read(void)
   {
     while(m_reply && m_reply->bytesAvailable() > 0)
       m_buffer.append(m_reply->readAll());
+
+    /*
+    ** The remainder of the file is not required.
+    */
+
+    if(!m_parsed && parse(false) && m_reply)
+      m_reply->abort();
   }
 
  signals:
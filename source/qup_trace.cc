@@ -0,0 +1,346 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+
+#include "qup_trace.h"
+
+const int static s_capacity = 8192; // Events per buffer.
+const int static s_maximum_buffers = 32;
+
+class qup_trace::Registry
+{
+ public:
+  Registry(void)
+  {
+    m_clock.start();
+    m_file_name = QString::fromLocal8Bit(qgetenv("QUP_TRACE").trimmed());
+    m_enabled = !m_file_name.isEmpty();
+  }
+
+  QElapsedTimer m_clock;
+  QMutex m_mutex;
+  QString m_file_name;
+  QVector<QSharedPointer<Buffer> > m_buffers;
+  QVector<Buffer *> m_free;
+  bool m_enabled;
+};
+
+class qup_trace::Lease
+{
+ public:
+  Lease(void)
+  {
+    m_buffer = nullptr;
+  }
+
+  ~Lease()
+  {
+    if(m_buffer)
+      {
+	QMutexLocker locker(&registry().m_mutex);
+
+	registry().m_free << m_buffer;
+      }
+  }
+
+  Buffer *m_buffer;
+};
+
+qup_trace::Span::Span
+(const char *category, const char *name, const QString &detail)
+{
+  m_begin = enabled() ? now() : -1;
+  m_category = category;
+  m_name = name;
+
+  if(m_begin >= 0)
+    m_detail = detail;
+}
+
+qup_trace::Span::~Span()
+{
+  if(m_begin >= 0)
+    record('X', m_category, m_name, m_begin, now() - m_begin, 0, 0, m_detail);
+}
+
+qup_trace::Buffer *qup_trace::buffer(void)
+{
+  /*
+  ** A buffer is returned to the registry as its thread exits and
+  ** retains its events for the next thread.
+  */
+
+  thread_local Lease lease;
+
+  if(!lease.m_buffer)
+    {
+      auto const thread = QThread::currentThread();
+      QMutexLocker locker(&registry().m_mutex);
+
+      if(!registry().m_free.isEmpty())
+	lease.m_buffer = registry().m_free.takeLast();
+      else if(registry().m_buffers.size() < s_maximum_buffers)
+	{
+	  auto value(QSharedPointer<Buffer>::create());
+
+	  value->m_events.resize(s_capacity);
+	  value->m_thread = registry().m_buffers.size() + 1;
+	  registry().m_buffers << value;
+	  lease.m_buffer = value.data();
+	}
+      else
+	return nullptr;
+
+      QMutexLocker ring_locker(&lease.m_buffer->m_mutex);
+
+      lease.m_buffer->m_name = QString("%1 %2").
+	arg(thread && !thread->objectName().isEmpty() ?
+	    thread->objectName() : "Thread").
+	arg(lease.m_buffer->m_thread);
+    }
+
+  return lease.m_buffer;
+}
+
+qup_trace::Registry &qup_trace::registry(void)
+{
+  static Registry registry;
+
+  return registry;
+}
+
+bool qup_trace::enabled(void)
+{
+  return registry().m_enabled;
+}
+
+bool qup_trace::write(const QString &file_name)
+{
+  QJsonArray events;
+  QVector<QSharedPointer<Buffer> > buffers;
+  auto const pid = QCoreApplication::applicationPid();
+  auto const microseconds = [](const qint64 nanoseconds)
+    {
+      return static_cast<double> (nanoseconds) / 1000.0;
+    };
+
+  {
+    QMutexLocker locker(&registry().m_mutex);
+
+    buffers = registry().m_buffers;
+  }
+
+  foreach(auto const &ring, buffers)
+    {
+      QMutexLocker locker(&ring->m_mutex);
+      QJsonObject metadata;
+      QJsonObject thread;
+      auto const count = qMin
+	(ring->m_recorded, static_cast<quint64> (s_capacity));
+
+      thread["name"] = ring->m_name;
+      metadata["args"] = thread;
+      metadata["name"] = "thread_name";
+      metadata["ph"] = "M";
+      metadata["pid"] = pid;
+      metadata["tid"] = ring->m_thread;
+      events.append(metadata);
+
+      for(auto i = ring->m_recorded - count; i < ring->m_recorded; i++)
+	{
+	  QJsonObject arguments;
+	  QJsonObject object;
+	  auto const &event
+	    (ring->m_events.at(static_cast<int> (i % s_capacity)));
+
+	  object["cat"] = event.m_category;
+	  object["name"] = event.m_name;
+	  object["ph"] = QString(QLatin1Char(event.m_phase));
+	  object["pid"] = pid;
+	  object["tid"] = ring->m_thread;
+	  object["ts"] = microseconds(event.m_time);
+
+	  switch(event.m_phase)
+	    {
+	    case 'C':
+	      {
+		arguments["value"] = event.m_value;
+		break;
+	      }
+	    case 'X':
+	      {
+		object["dur"] = microseconds(event.m_duration);
+		break;
+	      }
+	    case 'b':
+	    case 'e':
+	      {
+		object["id"] = QString("0x%1").arg(event.m_id, 0, 16);
+		break;
+	      }
+	    case 'i':
+	      {
+		object["s"] = "t";
+		break;
+	      }
+	    default:
+	      {
+		break;
+	      }
+	    }
+
+	  if(event.m_detail_length > 0)
+	    arguments["detail"] = QString
+	      (event.m_detail, event.m_detail_length);
+
+	  if(!arguments.isEmpty())
+	    object["args"] = arguments;
+
+	  events.append(object);
+	}
+    }
+
+  QJsonObject object;
+  QSaveFile file(file_name);
+
+  object["displayTimeUnit"] = "ms";
+  object["traceEvents"] = events;
+
+  if(file.open(QIODevice::Truncate | QIODevice::WriteOnly))
+    {
+      file.write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+      return file.commit();
+    }
+
+  return false;
+}
+
+qint64 qup_trace::now(void)
+{
+  return registry().m_clock.nsecsElapsed();
+}
+
+void qup_trace::async_begin(const char *category,
+			    const char *name,
+			    const quint64 id,
+			    const QString &detail)
+{
+  if(enabled())
+    record('b', category, name, now(), 0, 0, id, detail);
+}
+
+void qup_trace::async_end(const char *category,
+			  const char *name,
+			  const quint64 id)
+{
+  if(enabled())
+    record('e', category, name, now(), 0, 0, id, "");
+}
+
+void qup_trace::counter(const char *name, const qint64 value)
+{
+  if(enabled())
+    record('C', "counter", name, now(), 0, value, 0, "");
+}
+
+void qup_trace::dump(void)
+{
+  write(registry().m_file_name);
+}
+
+void qup_trace::initialize(void)
+{
+  /*
+  ** Must be issued by the main thread.
+  */
+
+  if(!enabled())
+    return;
+
+  auto const ring = buffer();
+
+  if(ring)
+    {
+      QMutexLocker locker(&ring->m_mutex);
+
+      ring->m_name = "Main";
+    }
+
+  qAddPostRoutine(&qup_trace::dump);
+}
+
+void qup_trace::instant(const char *category,
+			const char *name,
+			const QString &detail)
+{
+  if(enabled())
+    record('i', category, name, now(), 0, 0, 0, detail);
+}
+
+void qup_trace::record(const char phase,
+		       const char *category,
+		       const char *name,
+		       const qint64 time,
+		       const qint64 duration,
+		       const qint64 value,
+		       const quint64 id,
+		       const QString &detail)
+{
+  auto const ring = buffer();
+
+  if(!ring)
+    return;
+
+  QMutexLocker locker(&ring->m_mutex);
+  auto &event
+    (ring->m_events[static_cast<int> (ring->m_recorded % s_capacity)]);
+  auto const length = qMin
+    (static_cast<int> (detail.size()),
+     static_cast<int> (sizeof(event.m_detail) / sizeof(event.m_detail[0])));
+
+  std::copy(detail.constData() + detail.size() - length,
+	    detail.constData() + detail.size(),
+	    event.m_detail);
+  event.m_category = category;
+  event.m_detail_length = length;
+  event.m_duration = duration;
+  event.m_id = id;
+  event.m_name = name;
+  event.m_phase = phase;
+  event.m_time = time;
+  event.m_value = value;
+  ring->m_recorded += 1;
+}
@@ -0,0 +1,138 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_trace_h_
+#define _qup_trace_h_
+
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+/*
+** Spans, counters, and markers of every thread in the Chrome trace
+** format, which Perfetto and chrome://tracing open. Tracing is enabled
+** if QUP_TRACE names a file; the file is written as the application
+** exits. Each thread records into a ring buffer of fixed capacity and
+** the oldest events are replaced. The buffers of finished threads are
+** handed to new threads and their number is bounded; events of threads
+** beyond the bound are dropped. Details retain their trailing
+** characters. Names and categories must be string literals.
+** Thread-safe.
+*/
+
+class qup_trace
+{
+ public:
+  class Span
+  {
+  public:
+    Span(const char *category, const char *name, const QString &detail = "");
+    ~Span();
+
+  private:
+    QString m_detail;
+    const char *m_category;
+    const char *m_name;
+    qint64 m_begin;
+  };
+
+  static bool enabled(void);
+  static bool write(const QString &file_name);
+  static qint64 now(void);
+  static void async_begin(const char *category,
+			  const char *name,
+			  const quint64 id,
+			  const QString &detail = "");
+  static void async_end(const char *category,
+			const char *name,
+			const quint64 id);
+  static void counter(const char *name, const qint64 value);
+  static void initialize(void);
+  static void instant(const char *category,
+		      const char *name,
+		      const QString &detail = "");
+
+ private:
+  class Event
+  {
+  public:
+    Event(void)
+    {
+      m_category = "";
+      m_detail_length = 0;
+      m_duration = 0;
+      m_id = 0;
+      m_name = "";
+      m_phase = 'i';
+      m_time = 0;
+      m_value = 0;
+    }
+
+    QChar m_detail[24];
+    const char *m_category;
+    const char *m_name;
+    char m_phase;
+    int m_detail_length;
+    qint64 m_duration; // Nanoseconds.
+    qint64 m_time; // Nanoseconds.
+    qint64 m_value;
+    quint64 m_id;
+  };
+
+  class Buffer
+  {
+  public:
+    Buffer(void)
+    {
+      m_recorded = 0;
+      m_thread = 0;
+    }
+
+    QMutex m_mutex;
+    QString m_name;
+    QVector<Event> m_events;
+    int m_thread;
+    quint64 m_recorded;
+  };
+
+  class Lease;
+  class Registry;
+  static Buffer *buffer(void);
+  static Registry &registry(void);
+  static void dump(void);
+  static void record(const char phase,
+		     const char *category,
+		     const char *name,
+		     const qint64 time,
+		     const qint64 duration,
+		     const qint64 value,
+		     const quint64 id,
+		     const QString &detail);
+};
+
+#endif
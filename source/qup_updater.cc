@@ -0,0 +1,1207 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDir>
+#include <QNetworkReply>
+#include <QSettings>
+#include <QTextStream>
+#include <QTimer>
+
+#include "qup_files.h"
+#include "qup_staging.h"
+#include "qup_trace.h"
+#include "qup_updater.h"
+
+class PropertyNames
+{
+ public:
+  char const static *AbsoluteFilePath;
+  char const static *Connection;
+  char const static *DestinationDirectory;
+  char const static *DestinationFile;
+  char const static *Digest;
+  char const static *Dispatched;
+  char const static *Executable;
+  char const static *FileName;
+  char const static *FirstByte;
+  char const static *Queued;
+  char const static *Read;
+  char const static *Throttled;
+
+ private:
+  PropertyNames(void);
+};
+
+char const *PropertyNames::AbsoluteFilePath = "absolute_file_path";
+char const *PropertyNames::Connection = "connection";
+char const *PropertyNames::DestinationDirectory = "destination_directory";
+char const *PropertyNames::DestinationFile = "destination_file";
+char const *PropertyNames::Digest = "digest";
+char const *PropertyNames::Dispatched = "dispatched";
+char const *PropertyNames::Executable = "executable";
+char const *PropertyNames::FileName = "file_name";
+char const *PropertyNames::FirstByte = "first_byte";
+char const *PropertyNames::Queued = "queued";
+char const *PropertyNames::Read = "read";
+char const *PropertyNames::Throttled = "throttled";
+char const static *const s_end_of_file = "# End of file. Required comment.";
+const int static s_maximum_size_of_instruction_buffer = 5 * 1024 * 1024;
+const int static s_throttle_interval = 50; // Milliseconds.
+const qint64 static s_throttled_read_buffer_size = 256 * 1024;
+
+qup_updater::qup_updater(QObject *parent):QObject(parent)
+{
+  m_files = 0;
+  m_finished = true;
+  m_instruction_file_saved = false;
+  m_metrics = QSharedPointer<qup_metrics>::create();
+  m_network_access_manager.setRedirectPolicy
+    (QNetworkRequest::NoLessSafeRedirectPolicy);
+  m_ok = true;
+  m_parsed = false;
+  m_pool.setMaxThreadCount(1);
+  m_replies = 0;
+  m_staging_base = 0;
+  m_staging_bytes = 0;
+}
+
+qup_updater::~qup_updater()
+{
+  interrupt();
+}
+
+QString qup_updater::executable_suffix(void) const
+{
+  return QString(m_favorite.m_operating_system).replace(' ', '_').toLower();
+}
+
+QSharedPointer<qup_metrics> qup_updater::metrics(void) const
+{
+  return m_metrics;
+}
+
+QString qup_updater::path(void) const
+{
+  return m_path;
+}
+
+QStringList qup_updater::favorites(void)
+{
+  QMap<QString, char> names;
+  QSettings settings;
+
+  foreach(auto const &group, settings.childGroups())
+    if(group.startsWith("favorite-"))
+      {
+	settings.beginGroup(group);
+	names[settings.value("name").toString().trimmed()] = 0;
+	settings.endGroup();
+      }
+
+  names.remove("");
+  return names.keys();
+}
+
+QUrl qup_updater::string_as_url(const QString &s)
+{
+  auto string(s.trimmed());
+
+  while(string.contains("//"))
+    string.replace("//", "/");
+
+  if(string.endsWith("/"))
+    string = string.mid(0, string.length() - 1);
+
+  if(string.startsWith("ftp:/"))
+    string.replace(0, 5, "ftp://");
+  else if(string.startsWith("http:/"))
+    string.replace(0, 6, "http://");
+  else if(string.startsWith("https:/"))
+    string.replace(0, 7, "https://");
+
+  return QUrl::fromUserInput(string);
+}
+
+bool qup_updater::active(void) const
+{
+  return !m_finished ||
+    m_pool.activeThreadCount() > 0 ||
+    m_network_access_manager.findChildren<QNetworkReply *> ().size() > 0;
+}
+
+int qup_updater::downloaded_files(void) const
+{
+  return m_files;
+}
+
+qint64 qup_updater::downloaded_bytes(void) const
+{
+  return m_staging_bytes;
+}
+
+qup_updater::Favorite qup_updater::favorite(const QString &name)
+{
+  QSettings settings;
+  QVariantMap values;
+
+  settings.beginGroup(QString("favorite-%1").arg(name));
+
+  foreach(auto const &key, settings.childKeys())
+    values[key] = settings.value(key);
+
+  return favorite(values);
+}
+
+qup_updater::Favorite qup_updater::favorite(const QVariantMap &values)
+{
+  Favorite favorite;
+
+  favorite.m_destination = QDir::cleanPath
+    (values.value("local-directory").toString().trimmed());
+  favorite.m_durability = qup_installer::string_as_durability
+    (values.value("durability").toString());
+  favorite.m_install_automatically = values.value
+    ("install-automatically", false).toBool();
+  favorite.m_install_mode = qup_installer::string_as_mode
+    (values.value("install-mode").toString());
+  favorite.m_install_pipelined = values.value
+    ("install-pipelined", false).toBool();
+  favorite.m_keep_staged_files = values.value
+    ("keep-staged-files", true).toBool();
+  favorite.m_name = values.value("name").toString().trimmed();
+  favorite.m_operating_system = values.value
+    ("operating-system").toString().trimmed();
+  favorite.m_staging_directory = values.value
+    ("staging-directory").toString().trimmed();
+  favorite.m_staging_quota = 1048576LL * values.value
+    ("staging-quota").toLongLong();
+  favorite.m_url = string_as_url(values.value("url").toString());
+  return favorite;
+}
+
+void qup_updater::download(const Favorite &favorite)
+{
+  interrupt();
+  m_canceled.storeRelease(0);
+  m_mismatched.storeRelease(0);
+  m_favorite = favorite;
+  m_files = 0;
+  m_finished = false;
+  m_instruction_file_saved = false;
+  m_metrics->reset();
+  m_ok = true;
+  m_parsed = false;
+  m_path = qup_staging::path
+    (m_favorite.m_name,
+     m_favorite.m_destination,
+     m_favorite.m_staging_directory);
+  m_replies = 0;
+  m_staging_bytes = 0;
+
+  if(!QFileInfo(m_path).exists())
+    {
+      auto text(tr("<b>Creating %1... </b>").arg(m_path));
+
+      if(QDir().mkpath(m_path) == false)
+	{
+	  text.append(tr("<font color='darkred'>Failure.</font>"));
+	  emit append(text);
+	  fail();
+	  return;
+	}
+      else
+	text.append(tr("<font color='darkgreen'>Created.</font>"));
+
+      emit append(text);
+      qup_staging::mark(m_path);
+    }
+  else
+    {
+      emit append(tr("The destination path %1 exists.").arg(m_path));
+
+      if(qup_staging::marked(m_path))
+	qup_staging::mark(m_path);
+
+      /*
+      ** Files retained from earlier downloads count against the quota.
+      */
+
+      m_staging_base = qup_staging::size(m_path);
+    }
+
+  start_pipeline();
+
+  /*
+  ** Download the instructions file.
+  */
+
+  auto const url(m_favorite.m_url);
+
+  emit append(tr("<b>Downloading the file %1.</b>").arg(url.toString()));
+  m_metrics->begin(qup_metrics::Phases::Manifest);
+  m_instruction_file_reply = m_network_access_manager.get(QNetworkRequest(url));
+  m_instruction_file_reply_data.clear();
+  qup_trace::async_begin
+    ("network",
+     "Instruction file",
+     reinterpret_cast<quintptr> (m_instruction_file_reply.data()),
+     url.toString());
+  m_qup_txt_file_name = m_path + QDir::separator() + url.fileName();
+  m_qup_txt_file_name = qup_installer::proper_path(m_qup_txt_file_name);
+  connect(m_instruction_file_reply,
+	  &QNetworkReply::finished,
+	  this,
+	  &qup_updater::slot_instruction_reply_finished);
+  connect(m_instruction_file_reply,
+	  &QNetworkReply::readyRead,
+	  this,
+	  &qup_updater::slot_write_instruction_file_data);
+}
+
+void qup_updater::download_files(const QHash<QString, FileInformation> &files,
+				 const QString &directory_destination,
+				 const QString &file_destination,
+				 const QUrl &url)
+{
+  if(files.isEmpty() || url.isEmpty() || url.isValid() == false)
+    return;
+
+  QHashIterator<QString, FileInformation> it(files);
+
+  while(it.hasNext())
+    {
+      it.next();
+
+      if(it.key().trimmed().isEmpty())
+	continue;
+
+      Request request;
+      auto const dot = it.value().m_destination == "." ||
+	it.value().m_destination.startsWith("./");
+      auto remote_file_name(url.toString());
+
+      remote_file_name.append('/');
+      remote_file_name.append(it.key());
+      request.m_digest = it.value().m_digest;
+      request.m_directory_destination = dot ? "" : directory_destination;
+      request.m_executable = it.value().m_executable;
+      request.m_file_destination = dot ? it.key() : file_destination;
+      request.m_file_name = QFileInfo(it.key()).fileName();
+      request.m_queued = m_metrics->now();
+      request.m_url = string_as_url(remote_file_name);
+      m_replies += 1;
+      m_requests.enqueue(request);
+    }
+
+  slot_dispatch();
+}
+
+void qup_updater::fail(void)
+{
+  /*
+  ** The instruction file is not available.
+  */
+
+  if(m_finished)
+    return;
+
+  m_finished = true;
+  stop_pipeline();
+  emit finished(false);
+}
+
+void qup_updater::finish(void)
+{
+  /*
+  ** Every reply has completed.
+  */
+
+  if(m_finished)
+    return;
+
+  m_finished = true;
+  m_metrics->end(qup_metrics::Phases::Download);
+  emit downloads_finished();
+
+  if(!m_ok)
+    emit append
+      (tr("<font color='darkred'>Some of the files were not downloaded. "
+	  "Please review.</font>"));
+
+  if(m_pipeline)
+    {
+      if(m_ok)
+	emit append(tr("<b>Committing %1.</b>").arg(m_favorite.m_name));
+
+      finish_pipeline(m_ok);
+    }
+  else if(m_favorite.m_install_automatically)
+    install();
+  else
+    {
+      /*
+      ** Verifications may be pending.
+      */
+
+      auto const ok = m_ok;
+
+      m_pool.start([this, ok](void)
+		   {
+		     emit finished(ok && m_mismatched.loadAcquire() == 0);
+		   });
+    }
+}
+
+void qup_updater::finish_pipeline(const bool commit)
+{
+  if(!m_pipeline)
+    return;
+
+  auto const ok = m_ok;
+  auto pipeline(m_pipeline);
+
+  m_metrics->begin(qup_metrics::Phases::Install);
+  m_pipeline.clear();
+  m_pool.start([this, commit, ok, pipeline](void)
+	       {
+		 qup_trace::Span span("install", "Commit pipeline");
+
+		 if(commit &&
+		    m_canceled.loadAcquire() == 0 &&
+		    m_mismatched.loadAcquire() == 0)
+		   {
+		     auto const committed = pipeline->commit();
+
+		     m_metrics->end(qup_metrics::Phases::Install);
+		     emit finished(committed && ok);
+		   }
+		 else
+		   {
+		     pipeline->discard();
+		     m_metrics->end(qup_metrics::Phases::Install);
+		     emit finished(false);
+		   }
+	       });
+}
+
+void qup_updater::install(void)
+{
+  /*
+  ** The complete staging directory is installed after the downloads.
+  */
+
+  auto const disk_workers = m_budget ? m_budget->disk_workers() : nullptr;
+  auto const favorite(m_favorite);
+  auto const ok = m_ok;
+  auto const path(m_path);
+
+  emit append
+    (tr("<b>Copying files from %1 to %2.</b>").
+     arg(path).arg(favorite.m_destination));
+  m_metrics->begin(qup_metrics::Phases::Install);
+  m_pool.start([this, disk_workers, favorite, ok, path](void)
+	       {
+		 qup_trace::Span span("install", "Install", favorite.m_name);
+
+		 if(m_mismatched.loadAcquire() != 0)
+		   {
+		     emit append
+		       (tr("<font color='darkred'>%1 was not installed "
+			   "since some of its files are corrupt.</font>").
+			arg(favorite.m_name));
+		     m_metrics->end(qup_metrics::Phases::Install);
+		     emit finished(false);
+		     return;
+		   }
+
+		 qup_installer installer
+		   (favorite.m_destination, path, favorite.m_name);
+
+		 installer.set_append([this](const QString &text)
+				      {
+					emit append(text);
+				      });
+		 installer.set_canceled([this](void)
+					{
+					  return m_canceled.loadAcquire() != 0;
+					});
+		 installer.set_disk_workers(disk_workers);
+		 installer.set_durability(favorite.m_durability);
+		 installer.set_keep_staged_files(favorite.m_keep_staged_files);
+		 installer.set_mode(favorite.m_install_mode);
+
+		 auto const installed = installer.install();
+
+		 m_metrics->end(qup_metrics::Phases::Install);
+		 emit finished(installed && ok);
+	       });
+}
+
+void qup_updater::interrupt(void)
+{
+  /*
+  ** Interrupted updates do not report completion.
+  */
+
+  m_canceled.storeRelease(1);
+  m_finished = true;
+  m_requests.clear();
+
+  foreach(auto reply,
+	  m_network_access_manager.findChildren<QNetworkReply *> ())
+    if(reply)
+      reply->abort();
+
+  stop_pipeline();
+  m_pool.waitForDone();
+}
+
+void qup_updater::parse_instructions
+(QTextStream &stream,
+ const QString &suffix,
+ const std::function<void (const QHash<QString, FileInformation> &,
+			   const QString &,
+			   const QString &,
+			   const QUrl &)> &issue)
+{
+  /*
+  ** Each url line issues the files which precede it. Independent of
+  ** the network so that the parser may be measured.
+  */
+
+  QHash<QString, QString> digests;
+  QHash<QString, qup_updater::FileInformation> files;
+  QString file_destination("");
+  QString line("");
+  auto const digest = [&digests, &files](const QString &value)
+    {
+      /*
+      ** A digest line names a file and its SHA3-256 digest. The file
+      ** may be listed before or after its digest.
+      */
+
+      auto const p = value.lastIndexOf(' ');
+
+      if(p > 0)
+	digests[value.mid(0, p).trimmed()] = value.mid(p + 1).toLower();
+
+      QMutableHashIterator<QString, qup_updater::FileInformation> it(files);
+
+      while(it.hasNext())
+	{
+	  it.next();
+	  it.value().m_digest = digests.value(it.key());
+	}
+    };
+  auto general = false;
+  auto unix = false;
+
+  while(!stream.atEnd())
+    {
+      if(line.endsWith('\\'))
+	{
+	  auto l(stream.readLine().trimmed());
+	  auto const p = l.indexOf('#');
+
+	  if(p >= 0)
+	    l = l.mid(0, p).trimmed();
+
+	  line.remove('\\');
+	  line.append(l);
+	}
+      else
+	line = stream.readLine().trimmed();
+
+      auto const position = line.indexOf('#');
+
+      if(position >= 0)
+	line = line.mid(0, position).trimmed();
+
+      if(line.endsWith('\\') || line.isEmpty())
+	continue;
+
+      if(line == "[General]")
+	{
+	  general = true;
+	  continue;
+	}
+      else if(line == "[Unix]")
+	{
+#ifdef Q_OS_MACOS
+	  unix = false;
+#elif defined(Q_OS_UNIX)
+	  unix = true;
+#endif
+	  continue;
+	}
+      else if(line.startsWith('#'))
+	continue;
+
+      if(general)
+	{
+	  auto const list(line.split('='));
+	  auto const p
+	    (qMakePair(list.value(0).trimmed(), list.value(1).trimmed()));
+
+	  if(p.first.isEmpty() || p.second.isEmpty())
+	    continue;
+
+	  if(p.first == "digest")
+	    digest(p.second);
+	  else if(p.first == "file")
+	    {
+#if defined(Q_OS2) || defined(Q_OS_WINDOWS)
+#else
+	      if(p.second.toLower().endsWith(".dll"))
+		continue;
+#endif
+
+	      FileInformation file_information;
+
+	      file_information.m_digest = digests.value(p.second);
+	      file_information.m_executable = false;
+	      files[p.second] = file_information;
+	    }
+	  else if(p.first == "file_destination")
+	    file_destination = p.second;
+	  else if(p.first == "url")
+	    {
+	      /*
+	      ** Begin the download(s).
+	      */
+
+	      if(file_destination.isEmpty())
+		{
+		  QHashIterator<QString, qup_updater::FileInformation> it
+		    (files);
+
+		  while(it.hasNext())
+		    {
+		      it.next();
+
+		      QHash<QString, qup_updater::FileInformation> f;
+
+		      f[it.key()] = it.value();
+		      issue
+			(f,
+			 QFileInfo(it.key()).path(),     // Directory
+			 QFileInfo(it.key()).fileName(), // File
+			 string_as_url(p.second));
+		    }
+		}
+	      else
+		issue
+		  (files,
+		   file_destination, // Directory
+		   "",
+		   string_as_url(p.second));
+
+	      digests.clear();
+	      file_destination.clear();
+	      files.clear();
+	      general = false;
+	    }
+	}
+      else if(unix)
+	{
+	  auto const list(line.split('='));
+	  auto const p
+	    (qMakePair(list.value(0).trimmed(), list.value(1).trimmed()));
+
+	  if(p.first.isEmpty() || p.second.isEmpty())
+	    continue;
+
+	  if(p.first == "desktop" || p.first == "file")
+	    {
+	      FileInformation file_information;
+
+	      file_information.m_destination = p.second;
+	      file_information.m_digest = digests.value(p.second);
+	      file_information.m_executable = false;
+	      files[p.second] = file_information;
+	    }
+	  else if(p.first == "digest")
+	    digest(p.second);
+	  else if(p.first == "executable" &&
+		  p.second.toLower().endsWith(suffix))
+	    {
+	      FileInformation file_information;
+
+	      file_information.m_destination = "";
+	      file_information.m_digest = digests.value(p.second);
+	      file_information.m_executable = true;
+	      files[p.second] = file_information;
+	    }
+	  else if(p.first == "local_executable")
+	    file_destination = p.second;
+	  else if(p.first == "shell")
+	    {
+	      FileInformation file_information;
+
+	      file_information.m_destination = p.second;
+	      file_information.m_digest = digests.value(p.second);
+	      file_information.m_executable = true;
+	      files[p.second] = file_information;
+	    }
+	  else if(p.first == "url")
+	    {
+	      /*
+	      ** Begin the download(s).
+	      */
+
+	      issue
+		(files,
+		 "", // Directory
+		 file_destination,
+		 string_as_url(p.second));
+	      digests.clear();
+	      file_destination.clear();
+	      files.clear();
+	      unix = false;
+	    }
+	}
+    }
+}
+
+void qup_updater::set_budget(qup_budget *budget)
+{
+  if(m_budget)
+    disconnect(m_budget, nullptr, this, nullptr);
+
+  m_budget = budget;
+
+  if(m_budget)
+    connect(m_budget,
+	    &qup_budget::connection_released,
+	    this,
+	    &qup_updater::slot_dispatch);
+}
+
+void qup_updater::slot_dispatch(void)
+{
+  /*
+  ** Requests are issued as the budget permits.
+  */
+
+  qup_trace::Span span("network", "Dispatch");
+
+  while(!m_requests.isEmpty())
+    {
+      if(m_budget && !m_budget->acquire_connection())
+	break;
+
+      auto const request(m_requests.dequeue());
+
+      emit append(tr("Downloading %1.").arg(request.m_url.toString()));
+
+      auto reply = m_network_access_manager.get(QNetworkRequest(request.m_url));
+
+      reply->ignoreSslErrors();
+      reply->setProperty(PropertyNames::Connection, !m_budget.isNull());
+      reply->setProperty
+	(PropertyNames::DestinationDirectory, request.m_directory_destination);
+      reply->setProperty
+	(PropertyNames::DestinationFile, request.m_file_destination);
+      reply->setProperty(PropertyNames::Digest, request.m_digest);
+      reply->setProperty(PropertyNames::Dispatched, m_metrics->now());
+      reply->setProperty(PropertyNames::Executable, request.m_executable);
+      reply->setProperty(PropertyNames::FileName, request.m_file_name);
+      reply->setProperty(PropertyNames::Queued, request.m_queued);
+      qup_trace::async_begin
+	("network",
+	 "Download",
+	 reinterpret_cast<quintptr> (reply),
+	 request.m_file_name);
+
+      if(m_budget && m_budget->bandwidth() > 0)
+	reply->setReadBufferSize(s_throttled_read_buffer_size);
+
+      connect(reply,
+	      &QNetworkReply::finished,
+	      this,
+	      &qup_updater::slot_reply_finished);
+      connect(reply,
+	      &QNetworkReply::readyRead,
+	      this,
+	      &qup_updater::slot_write_file);
+    }
+
+  qup_trace::counter("Queued requests", m_requests.size());
+}
+
+void qup_updater::slot_instruction_reply_finished(void)
+{
+  if(m_instruction_file_reply)
+    {
+      if(!m_finished && !m_instruction_file_saved)
+	{
+	  if(m_instruction_file_reply->error() != QNetworkReply::NoError)
+	    emit append
+	      (tr("<font color='darkred'>Could not download %1. Perhaps "
+		  "the file does not exist.</font>").
+	       arg(m_instruction_file_reply->url().toString()));
+	  else
+	    emit append
+	      (tr("<font color='darkred'>The file %1 is incomplete.</font>").
+	       arg(m_instruction_file_reply->url().toString()));
+
+	  fail();
+	}
+
+      qup_trace::async_end
+	("network",
+	 "Instruction file",
+	 reinterpret_cast<quintptr> (m_instruction_file_reply.data()));
+      m_instruction_file_reply->deleteLater();
+    }
+}
+
+void qup_updater::slot_parse_instruction_file(void)
+{
+  qup_trace::async_end
+    ("wait", "Parse delay", reinterpret_cast<quintptr> (this));
+
+  if(m_finished || m_qup_txt_file_name.trimmed().isEmpty())
+    return;
+
+  qup_trace::Span span("updater", "Parse");
+
+  m_metrics->begin(qup_metrics::Phases::Download);
+  m_metrics->begin(qup_metrics::Phases::Parse);
+
+  QFile file(m_qup_txt_file_name);
+
+  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+      QTextStream stream(&file);
+
+      parse_instructions
+	(stream,
+	 executable_suffix(),
+	 [this](const QHash<QString, FileInformation> &files,
+		const QString &directory_destination,
+		const QString &file_destination,
+		const QUrl &url)
+	 {
+	   download_files(files, directory_destination, file_destination, url);
+	 });
+    }
+  else
+    {
+      emit append
+	(tr("<font color='darkred'>Cannot open %1 for processing.</font>").
+	 arg(m_qup_txt_file_name));
+      fail();
+      return;
+    }
+
+  m_metrics->end(qup_metrics::Phases::Parse);
+  m_parsed = true;
+  m_replies == 0 ? finish() : (void) 0;
+}
+
+void qup_updater::slot_reply_finished(void)
+{
+  auto reply = qobject_cast<QNetworkReply *> (sender());
+
+  if(!reply)
+    {
+      emit append
+	(tr("<font color='darkred'>Cannot discover QNetworkReply object. "
+	    "Serious problem!</font>"));
+      return;
+    }
+
+  qup_trace::Span span("network", "Reply finished");
+  auto const files = m_files;
+
+  if(reply->error() == QNetworkReply::NoError)
+    write_file(reply, true);
+
+  auto const absolute_file_path
+    (reply->property(PropertyNames::AbsoluteFilePath).toString());
+  auto const content_length
+    (reply->header(QNetworkRequest::ContentLengthHeader));
+
+  if(reply->error() != QNetworkReply::NoError)
+    {
+      if(!absolute_file_path.isEmpty())
+	QFile::remove(absolute_file_path);
+
+      emit append
+	(tr("<font color='darkred'>An error occurred while downloading %1."
+	    "</font>").
+	 arg(reply->property(PropertyNames::FileName).toString()));
+      m_ok = false;
+    }
+  else if(content_length.isValid() &&
+	  reply->hasRawHeader("Content-Encoding") == false &&
+	  QFileInfo(absolute_file_path).size() != content_length.toLongLong())
+    {
+      /*
+      ** Verification.
+      */
+
+      QFile::remove(absolute_file_path);
+      emit append
+	(tr("<font color='darkred'>The size of %1 differs from its "
+	    "announced size.</font>").
+	 arg(reply->property(PropertyNames::FileName).toString()));
+      m_ok = false;
+    }
+  else
+    {
+      emit append
+	(tr("<font color='darkgreen'>Completed downloading %1.</font>").
+	 arg(reply->property(PropertyNames::FileName).toString()));
+
+      if(reply->property(PropertyNames::Executable).toBool())
+	{
+	  QFile file(absolute_file_path);
+
+	  file.setPermissions(QFileDevice::ExeOwner | file.permissions());
+	}
+
+      m_files += 1;
+
+      /*
+      ** A file is verified against its published digest before it is
+      ** handed to the installer.
+      */
+
+      auto const digest
+	(reply->property(PropertyNames::Digest).toString());
+      auto const file_name
+	(reply->property(PropertyNames::FileName).toString());
+      auto pipeline(m_ok ? m_pipeline : QSharedPointer<qup_installer> ());
+
+      if(!absolute_file_path.isEmpty() && (!digest.isEmpty() || pipeline))
+	m_pool.start([this, absolute_file_path, digest, file_name, pipeline]
+		     (void)
+		     {
+		       if(!digest.isEmpty())
+			 {
+			   qup_trace::Span trace
+			     ("disk", "Verify", absolute_file_path);
+
+			   if(digest !=
+			      qup_files::digest_as_string
+			      (qup_files::file_digest(absolute_file_path)))
+			     {
+			       QFile::remove(absolute_file_path);
+			       m_mismatched.storeRelease(1);
+			       emit append
+				 (tr("<font color='darkred'>The digest of %1 "
+				     "differs from its published digest."
+				     "</font>").arg(file_name));
+			       return;
+			     }
+			 }
+
+		       if(pipeline)
+			 {
+			   qup_trace::Span trace
+			     ("install", "Install file", absolute_file_path);
+
+			   pipeline->install(absolute_file_path);
+			 }
+		     });
+	}
+    }
+
+  m_metrics->record_download
+    (reply->property(PropertyNames::Queued).toLongLong(),
+     reply->property(PropertyNames::Dispatched).toLongLong(),
+     reply->property(PropertyNames::FirstByte).isValid() ?
+     reply->property(PropertyNames::FirstByte).toLongLong() : -1,
+     m_metrics->now(),
+     m_files > files ? QFileInfo(absolute_file_path).size() : 0,
+     m_files > files);
+  m_replies -= 1;
+  qup_trace::async_end
+    ("network", "Download", reinterpret_cast<quintptr> (reply));
+  qup_trace::counter("Active replies", m_replies);
+  reply->deleteLater();
+
+  if(m_parsed && m_replies <= 0)
+    finish();
+
+  if(m_budget && reply->property(PropertyNames::Connection).toBool())
+    m_budget->release_connection();
+}
+
+void qup_updater::slot_write_file(void)
+{
+  write_file(qobject_cast<QNetworkReply *> (sender()), false);
+}
+
+void qup_updater::slot_write_instruction_file_data(void)
+{
+  if(!m_instruction_file_reply)
+    return;
+
+  while(m_instruction_file_reply->bytesAvailable() > 0)
+    {
+      m_instruction_file_reply_data.append
+	(m_instruction_file_reply->readAll());
+
+      if(m_instruction_file_reply_data.size() >
+	 s_maximum_size_of_instruction_buffer)
+	break;
+
+      if(m_instruction_file_reply_data.trimmed().endsWith(s_end_of_file))
+	break;
+    }
+
+  if(m_instruction_file_reply_data.trimmed().endsWith(s_end_of_file))
+    {
+      QFile file(m_qup_txt_file_name);
+      QFileInfo const file_information(m_qup_txt_file_name);
+
+      if(file.open(QIODevice::Text |
+		   QIODevice::Truncate |
+		   QIODevice::WriteOnly))
+	{
+	  if(file.write(m_instruction_file_reply_data) ==
+	     static_cast<qint64> (m_instruction_file_reply_data.length()))
+	    {
+	      m_instruction_file_saved = true;
+	      m_metrics->end(qup_metrics::Phases::Manifest);
+	      qup_trace::async_begin
+		("wait", "Parse delay", reinterpret_cast<quintptr> (this));
+	      QTimer::singleShot
+		(1000, this, &qup_updater::slot_parse_instruction_file);
+	      emit append
+		(tr("<font color='darkgreen'>File %1 saved locally.</font>").
+		 arg(file_information.fileName()));
+	    }
+	  else
+	    emit append
+	      (tr("<font color='darkred'>Could not write the entire file %1."
+		  "</font>").arg(file_information.fileName()));
+
+	  emit instruction_file_saved();
+	}
+      else
+	emit append
+	  (tr("<font color='darkred'>Could not open a local file %1.</file>").
+	   arg(file_information.fileName()));
+
+      m_instruction_file_reply->abort();
+      m_instruction_file_reply_data.clear();
+    }
+  else if(m_instruction_file_reply_data.size() >
+	  s_maximum_size_of_instruction_buffer)
+    {
+      m_instruction_file_reply->abort();
+      m_instruction_file_reply_data.clear();
+    }
+}
+
+void qup_updater::start_pipeline(void)
+{
+  /*
+  ** Files are installed into the prepared tree as they are downloaded
+  ** and verified. The tree is exchanged after the final download. In
+  ** Place installs would expose a partial release and are therefore
+  ** issued after the final download.
+  */
+
+  if(!m_favorite.m_install_automatically || !m_favorite.m_install_pipelined)
+    return;
+
+  if(m_favorite.m_install_mode != qup_installer::Modes::Swap)
+    {
+      emit append
+	(tr("Only Swap installs are pipelined. %1 will be installed after "
+	    "the final download.").arg(m_favorite.m_name));
+      return;
+    }
+
+  auto pipeline
+    (QSharedPointer<qup_installer>::create
+     (m_favorite.m_destination, m_path, m_favorite.m_name));
+
+  pipeline->set_append([this](const QString &text)
+		       {
+			 emit append(text);
+		       });
+  pipeline->set_canceled([this](void)
+			 {
+			   return m_canceled.loadAcquire() != 0;
+			 });
+  pipeline->set_disk_workers
+    (m_budget ? m_budget->disk_workers() : nullptr);
+  pipeline->set_durability(m_favorite.m_durability);
+  pipeline->set_keep_staged_files(m_favorite.m_keep_staged_files);
+  pipeline->set_mode(m_favorite.m_install_mode);
+  m_pipeline = pipeline;
+  m_pool.start([this, pipeline](void)
+	       {
+		 qup_trace::Span span("install", "Begin pipeline");
+
+		 if(!pipeline->begin())
+		   m_canceled.storeRelease(1);
+	       });
+}
+
+void qup_updater::stop_pipeline(void)
+{
+  if(m_pipeline)
+    {
+      auto pipeline(m_pipeline);
+
+      m_canceled.storeRelease(1);
+      m_pipeline.clear();
+      m_pool.start([pipeline](void)
+		   {
+		     qup_trace::Span span("install", "Discard pipeline");
+
+		     pipeline->discard();
+		   });
+    }
+}
+
+void qup_updater::write_file(QNetworkReply *reply, const bool drain)
+{
+  if(!reply)
+    return;
+
+  qup_trace::Span span("disk", "Write");
+
+  if(!reply->property(PropertyNames::FirstByte).isValid())
+    reply->setProperty(PropertyNames::FirstByte, m_metrics->now());
+
+  if(!reply->property(PropertyNames::DestinationDirectory).toString().isEmpty())
+    QDir().mkpath
+      (m_path +
+       QDir::separator() +
+       reply->property(PropertyNames::DestinationDirectory).toString());
+
+  QFile file;
+
+  if(!reply->property(PropertyNames::DestinationDirectory).toString().isEmpty())
+    file.setFileName
+      (m_path +
+       QDir::separator() +
+       reply->property(PropertyNames::DestinationDirectory).toString() +
+       QDir::separator() +
+       reply->property(PropertyNames::FileName).toString());
+  else
+    file.setFileName
+      (m_path +
+       QDir::separator() +
+       reply->property(PropertyNames::DestinationFile).toString());
+
+  QIODevice::OpenMode flags = QIODevice::NotOpen;
+
+  if(reply->property(PropertyNames::Read).toBool())
+    flags = QIODevice::Append | QIODevice::WriteOnly;
+  else
+    flags = QIODevice::Truncate | QIODevice::WriteOnly;
+
+  reply->setProperty(PropertyNames::AbsoluteFilePath, file.fileName());
+
+  /*
+  ** Bytes which are not granted remain in the reply's bounded buffer.
+  ** Remaining bytes are drained once the reply has finished.
+  */
+
+  auto available = reply->bytesAvailable();
+
+  if(m_budget && !drain)
+    {
+      auto const granted = m_budget->take(available);
+
+      if(granted < available &&
+	 !reply->property(PropertyNames::Throttled).toBool())
+	{
+	  qup_trace::instant
+	    ("network",
+	     "Throttled",
+	     reply->property(PropertyNames::FileName).toString());
+	  reply->setProperty(PropertyNames::Throttled, true);
+	  QTimer::singleShot
+	    (s_throttle_interval, reply, [this, reply](void)
+	     {
+	       reply->setProperty(PropertyNames::Throttled, false);
+	       write_file(reply, false);
+	     });
+	}
+
+      available = granted;
+    }
+  else if(m_budget)
+    m_budget->charge(available);
+
+  if(available <= 0)
+    return;
+
+  if(!reply->property(PropertyNames::Read).toBool())
+    {
+      /*
+      ** A retained file is replaced.
+      */
+
+      m_staging_base = qMax
+	(static_cast<qint64> (0),
+	 m_staging_base - QFileInfo(file.fileName()).size());
+    }
+
+  reply->setProperty(PropertyNames::Read, true);
+
+  if(file.open(flags))
+    while(available > 0)
+      {
+	auto const data(reply->read(available));
+
+	if(data.isEmpty())
+	  break;
+
+	available -= static_cast<qint64> (data.size());
+	m_staging_bytes += qMax
+	  (static_cast<qint64> (0), file.write(data));
+      }
+
+  if(m_ok &&
+     m_favorite.m_staging_quota > 0 &&
+     m_staging_base + m_staging_bytes > m_favorite.m_staging_quota)
+    {
+      emit append
+	(tr("<font color='darkred'>The staging quota of %1 bytes has been "
+	    "exceeded. Interrupting downloads.</font>").
+	 arg(m_favorite.m_staging_quota));
+      m_ok = false;
+      m_replies -= m_requests.size();
+      m_requests.clear();
+
+      foreach(auto reply,
+	      m_network_access_manager.findChildren<QNetworkReply *> ())
+	if(reply)
+	  reply->abort();
+    }
+}
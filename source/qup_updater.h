@@ -0,0 +1,176 @@
+/*
+** Copyright (c) 2024, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Glitch without specific prior written permission.
+**
+** QUP IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** QUP, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _qup_updater_h_
+#define _qup_updater_h_
+
+#include <QAtomicInt>
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QUrl>
+#include <QVariantMap>
+
+#include "qup_budget.h"
+#include "qup_metrics.h"
+#include "qup_installer.h"
+
+class QTextStream;
+
+/*
+** Retrieves a favorite's instruction file, downloads and verifies the
+** product files, and installs them if so configured. Widgets are not
+** required.
+*/
+
+class qup_updater: public QObject
+{
+  Q_OBJECT
+
+ public:
+  class Favorite
+  {
+  public:
+    Favorite(void)
+    {
+      m_durability = qup_installer::Durabilities::Batched;
+      m_install_automatically = false;
+      m_install_mode = qup_installer::Modes::InPlace;
+      m_install_pipelined = false;
+      m_keep_staged_files = true;
+      m_staging_quota = 0;
+    }
+
+    QString m_destination;
+    QString m_name;
+    QString m_operating_system;
+    QString m_staging_directory;
+    QUrl m_url;
+    bool m_install_automatically;
+    bool m_install_pipelined;
+    bool m_keep_staged_files;
+    qint64 m_staging_quota; // Bytes.
+    qup_installer::Durabilities m_durability;
+    qup_installer::Modes m_install_mode;
+  };
+
+  class FileInformation
+  {
+  public:
+    QString m_destination;
+    QString m_digest; // SHA3-256, hexadecimal.
+    bool m_executable;
+  };
+
+  qup_updater(QObject *parent);
+  ~qup_updater();
+  QSharedPointer<qup_metrics> metrics(void) const;
+  QString path(void) const;
+  bool active(void) const;
+  int downloaded_files(void) const;
+  qint64 downloaded_bytes(void) const;
+  static Favorite favorite(const QString &name);
+  static Favorite favorite(const QVariantMap &values);
+  static QStringList favorites(void);
+  static QUrl string_as_url(const QString &s);
+  static void parse_instructions
+    (QTextStream &stream,
+     const QString &suffix,
+     const std::function<void (const QHash<QString, FileInformation> &,
+			       const QString &,
+			       const QString &,
+			       const QUrl &)> &issue);
+  void download(const Favorite &favorite);
+  void interrupt(void);
+  void set_budget(qup_budget *budget);
+
+ private:
+  class Request
+  {
+  public:
+    QString m_digest;
+    QString m_directory_destination;
+    QString m_file_destination;
+    QString m_file_name;
+    QUrl m_url;
+    bool m_executable;
+    qint64 m_queued; // qup_metrics::now().
+  };
+
+  Favorite m_favorite;
+  QAtomicInt m_canceled;
+  QAtomicInt m_mismatched;
+  QByteArray m_instruction_file_reply_data;
+  QNetworkAccessManager m_network_access_manager;
+  QPointer<QNetworkReply> m_instruction_file_reply;
+  QPointer<qup_budget> m_budget;
+  QQueue<Request> m_requests;
+  QSharedPointer<qup_installer> m_pipeline;
+  QSharedPointer<qup_metrics> m_metrics;
+  QString m_path;
+  QString m_qup_txt_file_name;
+  QThreadPool m_pool;
+  bool m_finished;
+  bool m_instruction_file_saved;
+  bool m_ok;
+  bool m_parsed;
+  int m_files;
+  int m_replies;
+  qint64 m_staging_base;
+  qint64 m_staging_bytes;
+  QString executable_suffix(void) const;
+  void download_files
+    (const QHash<QString, FileInformation> &files,
+     const QString &directory_destination,
+     const QString &file_destination,
+     const QUrl &url);
+  void fail(void);
+  void finish(void);
+  void finish_pipeline(const bool commit);
+  void install(void);
+  void start_pipeline(void);
+  void stop_pipeline(void);
+  void write_file(QNetworkReply *reply, const bool drain);
+
+ private slots:
+  void slot_dispatch(void);
+  void slot_instruction_reply_finished(void);
+  void slot_parse_instruction_file(void);
+  void slot_reply_finished(void);
+  void slot_write_file(void);
+  void slot_write_instruction_file_data(void);
+
+ signals:
+  void append(const QString &text);
+  void downloads_finished(void);
+  void finished(const bool ok);
+  void instruction_file_saved(void);
+};
+
+#endif